@@ -22,51 +22,36 @@ enum {
 };
 
 #define ADC1_CHANNEL_COUNT ENUM_ADC_CHANNEL_COUNT
-#define ADC_MEAN_CHANNEL_COUNT 6
-#define ADC_RMS_CHANNEL_COUNT 1
-
-#define ADC_MEAN_BUFFER_SIZE 64
-#define ADC_MEAN_SAMPLE_SIZE 64
-
-#define ADC_RMS_BUFFER_SIZE 20
-
-#define SAMPLE_2N 6
-
-#define N_VALUE 18
-
-#define M1	Q15(0.04004)
-#define C1	-94
 
-#define M2	Q15(0.021)
-#define C2	-31
+#define ADC_SAMPLE_RATE_HZ 1000 /* TIM3 TRGO: 24MHz / 24 / 1000 */
 
-#define M3	Q15(0.05)
-#define C3	Q15(-121)
-
-#define M4	Q15(0.04)
-#define C4	-75
+/* DMA circular buffer holds two halves of ADC_DMA_SEQ_PER_HALF sequences each.
+ * HT and TC interrupts each process one half as a block. */
+#define ADC_DMA_SEQ_PER_HALF 4
+#define ADC_DMA_SEQ_COUNT (2 * ADC_DMA_SEQ_PER_HALF)
+#define ADC_MEAN_CHANNEL_COUNT 6
+#define ADC_RMS_CHANNEL_COUNT 1
 
-#define M5	Q15(0.03)
-#define C5	-25
+/* adcGain[listIDC2 + n] applies up to these raw counts (see adcIdc2Curve) */
+#define IDC2_SEG0_MAX 50
+#define IDC2_SEG1_MAX 150
+#define IDC2_SEG2_MAX 350
+#define IDC2_ADC_MAX  4095
+#define IDC2_CURVE_POINTS 6
 
 #include "main.h"
+#include "pwl.h"
 
 extern void adc_init();
 extern void calculationTemp(uint16_t adcValue);
+extern void adc_idc2_curve_update(void);
+extern void adc_process_block(const q15_t (*seq)[ADC1_CHANNEL_COUNT], uint8_t count);
 
-extern q15_t adc1Buffer[ADC1_CHANNEL_COUNT];
+extern q15_t adc1Buffer[ADC_DMA_SEQ_COUNT][ADC1_CHANNEL_COUNT];
 extern int16_t adcBuffer[ADC1_CHANNEL_COUNT];
 extern int16_t adcGain[ADC1_CHANNEL_COUNT + 3];
 extern uint16_t dcOffset;
 
-extern q15_t adcMeanBuffer[ADC1_CHANNEL_COUNT][ADC_MEAN_BUFFER_SIZE];
-extern int32_t adcMeanSum[ADC_MEAN_CHANNEL_COUNT];
-extern uint8_t adcMeanBufferPo;
-
-extern int32_t adcRmsBuffer[ADC_RMS_BUFFER_SIZE];
-extern int64_t adcRmsSum;
-extern uint8_t adcRmsBufferPo;
-
 extern uint16_t adcVAC;
 extern uint16_t adcTEMP;
 extern uint16_t adcIDC;
@@ -75,6 +60,9 @@ extern uint16_t adcVDC1;
 extern uint16_t adcVDC2;
 extern uint16_t adcIDC2NoGain;
 extern uint16_t adcIDC2;
-extern uint8_t temp;
+extern int16_t temp;
+
+extern const PWL_TABLE ntcTempCurve;
+extern const PWL_TABLE adcIdc2Curve;
 
 #endif /* INC_ADC_H_ */
@@ -0,0 +1,53 @@
+/*
+ * adc_filter.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_ADC_FILTER_H_
+#define INC_ADC_FILTER_H_
+
+#include "main.h"
+#include "adc.h"
+
+/* Two cascaded first-order IIR stages per channel on raw ADC counts:
+ *   s1 += ((x << 16) - s1) >> k
+ *   s2 += (s1 - s2) >> k
+ * Time constant of each stage is 2^k samples. k = 5 gives about the same
+ * white-noise rejection as the old 64-sample moving average with a
+ * steeper roll-off, using 8 bytes of state instead of 128. */
+#define ADC_FILTER_FRAC 16
+
+#define ADC_FILTER_K_TEMP   7
+#define ADC_FILTER_K_IDC    5
+#define ADC_FILTER_K_VBAT1  5
+#define ADC_FILTER_K_VDC1   5
+#define ADC_FILTER_K_VDC2   5
+#define ADC_FILTER_K_IDC2   5
+
+typedef struct
+{
+	int32_t s1;
+	int32_t s2;
+} ADC_FILTER;
+
+/* Indexed [ch - 1] like the other mean-channel tables (VAC is not filtered) */
+extern ADC_FILTER adcFilter[ADC_MEAN_CHANNEL_COUNT];
+extern const uint8_t adcFilterShift[ADC_MEAN_CHANNEL_COUNT];
+
+extern void adc_filter_init(void);
+extern uint16_t adc_filter_out(uint8_t ch);
+extern uint16_t adc_filter_scaled(uint8_t ch);
+
+/* Runs in the DMA ISR for every sample, keep it inline */
+static inline void adc_filter_update(uint8_t ch, int32_t raw)
+{
+	ADC_FILTER *f = &adcFilter[ch - 1];
+	uint8_t k = adcFilterShift[ch - 1];
+
+	f->s1 += ((raw << ADC_FILTER_FRAC) - f->s1) >> k;
+	f->s2 += (f->s1 - f->s2) >> k;
+}
+
+#endif /* INC_ADC_FILTER_H_ */
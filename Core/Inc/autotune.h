@@ -0,0 +1,70 @@
+/*
+ * autotune.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_AUTOTUNE_H_
+#define INC_AUTOTUNE_H_
+
+#include "main.h"
+
+/* Relay-feedback autotune (Astrom-Hagglund). The control tick drives the DAC
+ * with center +- AT_RELAY_D around the present operating point, measures the
+ * limit cycle and the background turns Ku/Tu into Ziegler-Nichols PI gains.
+ * The results are the gain schedule's base gains (pidVoutBase/pidIoutBase,
+ * unscaled by the schedule factor at the tuned point); pidVout/pidIout are
+ * not written here, gs_apply() derives them from the base every tick. */
+
+#define AT_RELAY_D          200     /* relay amplitude, DAC codes */
+#define AT_HYST             1       /* relay hysteresis, 0.1V / 0.1A */
+#define AT_MAX_DEV          30      /* abort if the output leaves setpoint +- this */
+#define AT_SKIP_CYCLES      2       /* settling cycles, not measured */
+#define AT_MEAS_CYCLES      4       /* averaged cycles */
+#define AT_TIMEOUT_TICKS    (10u * OUT_CONTROL_RATE_HZ)
+
+typedef enum {
+	AT_IDLE = 0,
+	AT_RUNNING,         /* relay active (tick) */
+	AT_MEASURED,        /* cycles done, gains pending (background) */
+	AT_DONE,
+	AT_ABORTED
+} AutotuneState_t;
+
+typedef enum {
+	AT_LOOP_V = 0,      /* pidVout on VBAT */
+	AT_LOOP_I           /* pidIout on I_DC2 */
+} AutotuneLoop_t;
+
+typedef struct
+{
+	AutotuneLoop_t loop;
+	volatile AutotuneState_t state;
+	int32_t setpoint;
+	int16_t center;
+	uint8_t high;
+	uint8_t cycles;
+	uint32_t ticks;
+	uint32_t lastRise;
+	uint32_t periodSum;     /* ticks over the measured cycles */
+	int32_t yMax;
+	int32_t yMin;
+	int32_t ampSum;         /* peak-to-peak sum over the measured cycles */
+
+	/* results */
+	uint16_t tu_ms;
+	uint16_t ku_q4;         /* DAC codes per unit, Q4 */
+	int32_t kp;             /* Q12, at the tuned point, before gs_set_base() */
+	int32_t ki;             /* Q12, per tick */
+} AUTOTUNE;
+
+extern AUTOTUNE autotune;
+
+extern void autotune_start(AutotuneLoop_t loop, int32_t setpoint, int16_t center);
+extern void autotune_abort(void);
+extern uint8_t autotune_active(void);
+extern int16_t autotune_step(int32_t measured);
+extern void autotune_update(void);
+
+#endif /* INC_AUTOTUNE_H_ */
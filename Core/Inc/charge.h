@@ -0,0 +1,128 @@
+/*
+ * charge.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_CHARGE_H_
+#define INC_CHARGE_H_
+
+#include "main.h"
+#include "out_control.h"
+#include "slope.h"
+
+/* Table-driven charge stages. Setpoints (0.1V / 0.1A, the PID units) and
+ * the exit thresholds (raw filtered ADC counts) are computed in the
+ * background whenever batInfo or the calibration changes, the control tick
+ * only compares counts and counts minutes. */
+
+#define CHG_HOLD_TICKS      OUT_CONTROL_RATE_HZ         /* exit condition must hold 1 s */
+#define CHG_TICKS_PER_MIN   (60u * OUT_CONTROL_RATE_HZ)
+#define CHG_V_MARGIN_dV     1       /* BULK ends this close to the absorption target */
+#define CHG_DEEP_PCT        72      /* deep discharge below 72% of absorption (10.5V of 14.6V) */
+#define CHG_REBULK_PCT      96      /* back to BULK below 96% of float (13.25V of 13.8V), of storage in STORAGE */
+#define CHG_EQL_SHIFT       4       /* equalization = absorption + absorption / 16 */
+#define CHG_SAFE_I_DIV      4       /* SAFE current = bulk / 4 */
+#define CHG_EQL_I_DIV       10      /* EQUALIZATION current = bulk / 10 */
+
+/* Absorption end (CHG_EXIT_TAPER): V_BAT1 and I_DC2 go into 2 min
+ * least-squares windows (slope.h, one sample every 2 s). A window passes
+ * when the mean current is below the finish current, the current changes
+ * less than 1/8 of the finish current per minute and the voltage less than
+ * CHG_TAPER_DV_mV per minute; CHG_TAPER_WINDOWS passing windows in a row end
+ * the stage. */
+#define CHG_SLOPE_S         2
+#define CHG_SLOPE_TICKS     (CHG_SLOPE_S * OUT_CONTROL_RATE_HZ)
+#define CHG_TAPER_DI_DIV    8
+#define CHG_TAPER_DV_mV     10
+#define CHG_TAPER_WINDOWS   3
+
+/* Deep-discharge recovery (STATE_BATTERY_SAFE): the voltage reference starts
+ * at the battery voltage and rises by safeStepMV per cell every
+ * CHG_SAFE_STEP_TICKS while the current stays under the SAFE limit; at the
+ * limit it holds. The stage is accepted (BULK) once the battery is above
+ * the deep-discharge level with at least 1/4 of the limit flowing. */
+#define CHG_SAFE_STEP_TICKS  (5u * OUT_CONTROL_RATE_HZ)
+#define CHG_SAFE_TRIP_MUL    2      /* current above 2x the limit: abort at once */
+#define CHG_SAFE_MIN_DIV     4      /* "accepting" above limit / 4 */
+#define CHG_SAFE_SHORT_dV    20     /* per 12V block: limit current below 2V is a short */
+#define CHG_SAFE_SHORT_TICKS (OUT_CONTROL_RATE_HZ / 10u)
+#define CHG_SAFE_MAX_dV      5      /* V_BAT1 0.5V over the ceiling: no battery */
+#define CHG_SAFE_OPEN_TICKS  (30u * OUT_CONTROL_RATE_HZ)    /* at the ceiling without current */
+
+#define CHG_NEXT_OFF        0xFF    /* stage table: switch the output off */
+
+/* Setpoints, 0.1V / 0.1A */
+enum {
+	CHG_SP_ABS_V = 0,
+	CHG_SP_FLOAT_V,
+	CHG_SP_STORE_V,
+	CHG_SP_EQL_V,
+	CHG_SP_SAFE_V,
+	CHG_SP_BULK_I,
+	CHG_SP_SAFE_I,
+	CHG_SP_EQL_I,
+	CHG_SP_COUNT
+};
+
+/* Exit thresholds, raw filtered counts */
+enum {
+	CHG_TH_NONE = 0,
+	CHG_TH_ABS_V,           /* V_BAT1 at the absorption target */
+	CHG_TH_DEEP_V,          /* V_BAT1 recovered from deep discharge */
+	CHG_TH_REBULK_V,        /* V_BAT1 sagging under load, FLOAT */
+	CHG_TH_STORE_V,         /* same in STORAGE, 96% of the storage voltage */
+	CHG_TH_FINISH_I,        /* I_DC2 tail current */
+	CHG_TH_SAFE_LIM_I,      /* I_DC2 at the SAFE current, stepping holds */
+	CHG_TH_SAFE_MIN_I,      /* I_DC2 of a battery taking charge */
+	CHG_TH_SAFE_TRIP_I,     /* I_DC2 anomaly, immediate abort */
+	CHG_TH_SAFE_SHORT_V,    /* V_BAT1 of a shorted battery */
+	CHG_TH_SAFE_MAX_V,      /* V_BAT1 above the probe ceiling: no battery */
+	CHG_TH_COUNT
+};
+
+typedef enum {
+	CHG_EXIT_NONE = 0,      /* timer only */
+	CHG_EXIT_V_ABOVE,
+	CHG_EXIT_V_BELOW,
+	CHG_EXIT_I_BELOW,
+	CHG_EXIT_TAPER,         /* current low and settled, voltage settled */
+	CHG_EXIT_SAFE           /* recovered and taking charge */
+} ChargeExit_t;
+
+/* Loops of a stage under REG_STAGED. Voltage stages that carry their own
+ * small current limit (SAFE, EQUALIZATION) run both loops min-selected, so
+ * that limit is regulated and not only tripped on. */
+typedef enum {
+	CHG_LOOP_CV = 0,
+	CHG_LOOP_CC,
+	CHG_LOOP_CVCC
+} ChargeLoop_t;
+
+typedef struct
+{
+	uint8_t  loop;          /* ChargeLoop_t */
+	uint8_t  vSp;           /* CHG_SP_* */
+	uint8_t  iSp;
+	uint8_t  exitCond;      /* ChargeExit_t */
+	uint8_t  exitTh;        /* CHG_TH_* */
+	uint8_t  exitNext;      /* ChargeState_t or CHG_NEXT_OFF */
+	uint16_t timeout_min;   /* 0: no stage timer */
+	uint8_t  timeoutNext;
+} CHARGE_STAGE;
+
+extern uint16_t chargeSetpoint[CHG_SP_COUNT];
+extern uint16_t chargeThRaw[CHG_TH_COUNT];
+extern uint16_t chargeStageMinutes;
+extern SLOPE chargeSlopeV;
+extern SLOPE chargeSlopeI;
+
+extern void charge_update_limits(void);
+extern void charge_start(void);
+extern void charge_tick(void);
+extern uint8_t charge_stage_loop(void);
+extern uint16_t charge_vset(void);
+extern uint16_t charge_iset(void);
+
+#endif /* INC_CHARGE_H_ */
@@ -0,0 +1,71 @@
+/*
+ * eis.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_EIS_H_
+#define INC_EIS_H_
+
+#include "main.h"
+
+/* Impedance sweep (PAGE_OUTPUT_CONTROL, charger mode). The DAC is held at
+ * the present operating point and the control tick adds a table sine of
+ * EIS_AMP_DAC codes. For each frequency the ADC block handler runs one
+ * Goertzel bin per channel (V_BAT1, I_DC2) over EIS_N sequences, the
+ * background divides the phasors into a complex impedance. Both phasors
+ * come from the same samples, so the converter's own gain and phase cancel. */
+
+#define EIS_POINTS          8
+#define EIS_N               1000    /* sequences per bin: 1 s, whole cycles at every frequency */
+#define EIS_AMP_DAC         100     /* perturbation amplitude, DAC codes */
+#define EIS_SETTLE_TICKS    (500u * OUT_CONTROL_RATE_HZ / 1000u)
+#define EIS_DETECT_TICKS    (2u * OUT_CONTROL_RATE_HZ)  /* bin must finish in 2 s */
+#define EIS_MIN_I_dA        20      /* operating current, the sine must not reach zero */
+#define EIS_MIN_AMP_RAW     4       /* I_DC2 response below this (counts): no result */
+#define EIS_V_MARGIN_dV     5       /* abort above the stage voltage + 0.5V */
+
+typedef enum {
+	EIS_IDLE = 0,
+	EIS_SETTLE,         /* sine running, waiting for the response to settle (tick) */
+	EIS_DETECT,         /* Goertzel bins (ADC block handler) */
+	EIS_POINT,          /* bin done, impedance pending (background) */
+	EIS_DONE,
+	EIS_FAILED
+} EisState_t;
+
+typedef struct
+{
+	int32_t re_uOhm;
+	int32_t im_uOhm;            /* negative: capacitive */
+} EIS_RESULT;
+
+typedef struct
+{
+	volatile EisState_t state;
+	uint8_t  point;
+	int16_t  dacHold;
+	uint32_t phase;             /* sine phase, 2^32 = one cycle */
+	uint32_t ticks;
+
+	/* Goertzel (ADC block handler) */
+	uint16_t n;
+	uint16_t vRef;              /* removed DC, raw counts */
+	uint16_t iRef;
+	int32_t  v1, v2;
+	int32_t  i1, i2;
+} EIS;
+
+extern EIS eis;
+extern EIS_RESULT eisTable[EIS_POINTS];        /* last sweep */
+extern const uint16_t eisFreq_Hz[EIS_POINTS];
+
+extern void eis_start(void);
+extern void eis_abort(void);
+extern uint8_t eis_active(void);
+extern void eis_sample(uint16_t iRaw, uint16_t vRaw);
+extern void eis_tick(void);
+extern void eis_update(void);
+
+#endif /* INC_EIS_H_ */
@@ -0,0 +1,36 @@
+/*
+ * feedforward.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_FEEDFORWARD_H_
+#define INC_FEEDFORWARD_H_
+
+#include "main.h"
+
+/* Output model dac = gain * V + offset, learned from steady (VBAT, dacValueV)
+ * pairs. The control tick collects blocks, the background fits them. */
+
+#define FF_BLOCK_SHIFT      10      /* 1024 ticks per averaged point */
+#define FF_STEADY_DAC       4       /* max DAC step per tick inside a block */
+#define FF_FORGET_SHIFT     5       /* fit memory ~32 blocks */
+#define FF_MIN_SPREAD_dV    5       /* VBAT spread needed to fit the gain */
+
+typedef struct
+{
+	int32_t gain;       /* Q12, DAC codes per 0.1V */
+	int32_t offset;     /* DAC codes */
+	uint8_t valid;
+} FF_MODEL;
+
+extern FF_MODEL ffModel;
+
+extern int16_t ff_dac(int32_t v_dV);
+extern void ff_sample(int32_t v_dV, int16_t dac);
+extern void ff_restart(void);
+extern uint8_t ff_install(void);
+extern void ff_update(void);
+
+#endif /* INC_FEEDFORWARD_H_ */
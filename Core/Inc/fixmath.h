@@ -0,0 +1,57 @@
+/*
+ * fixmath.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_FIXMATH_H_
+#define INC_FIXMATH_H_
+
+#include "main.h"
+
+/* Integer-only helpers used instead of double/libm. The Cortex-M3 has no FPU,
+ * every double operation pulls in the soft-float __aeabi_d* routines. */
+
+extern uint32_t fx_isqrt32(uint32_t x);
+extern uint32_t fx_isqrt64(uint64_t x);
+extern uint32_t fx_recip(uint32_t d);
+
+/* Saturate to int16 range (SSAT on the M3) */
+static inline int16_t fx_sat16(int32_t x)
+{
+	return (int16_t)__SSAT(x, 16);
+}
+
+/* Q15 x Q15 -> Q15, rounded and saturated */
+static inline q15_t fx_mul_q15(q15_t a, q15_t b)
+{
+	return (q15_t)__SSAT((((int32_t)a * b) + (1 << 14)) >> 15, 16);
+}
+
+/* Q31 x Q31 -> Q31, saturated (only -1 * -1 overflows) */
+static inline q31_t fx_mul_q31(q31_t a, q31_t b)
+{
+	int64_t p = ((int64_t)a * b) >> 31;
+
+	if (p > INT32_MAX)
+	{
+		return INT32_MAX;
+	}
+	return (q31_t)p;
+}
+
+/* x * m >> sh with a 64-bit intermediate, for scaling by Qn constants */
+static inline int32_t fx_mul_shift(int32_t x, int32_t m, uint8_t sh)
+{
+	return (int32_t)(((int64_t)x * m) >> sh);
+}
+
+/* n / d as n * fx_recip(d) >> 32, for divisors that change rarely.
+ * Exact while n and d are below 2^16, may be one high for larger n. */
+static inline uint32_t fx_div_recip(uint32_t n, uint32_t recip)
+{
+	return (uint32_t)(((uint64_t)n * recip) >> 32);
+}
+
+#endif /* INC_FIXMATH_H_ */
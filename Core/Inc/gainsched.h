@@ -0,0 +1,42 @@
+/*
+ * gainsched.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_GAINSCHED_H_
+#define INC_GAINSCHED_H_
+
+#include "main.h"
+
+/* Operating-point gain schedule. Flash tables hold Q12 scale factors
+ * (4096 = base gain) on a power-of-two grid, so the bilinear lookup needs
+ * only shifts and masks. Output voltage axis 0..51.2V in 6.4V steps,
+ * current axis 0..51.2A in 12.8A steps. */
+
+#define GS_V_SHIFT      6                               /* 64 x 0.1V */
+#define GS_V_POINTS     9
+#define GS_I_SHIFT      7                               /* 128 x 0.1A */
+#define GS_I_POINTS     5
+
+#define GS_V_MAX        (((GS_V_POINTS - 1) << GS_V_SHIFT) - 1)
+#define GS_I_MAX        (((GS_I_POINTS - 1) << GS_I_SHIFT) - 1)
+
+typedef struct
+{
+	int32_t kp;     /* Q12 */
+	int32_t ki;     /* Q12, per tick */
+	int32_t kd;     /* Q12, per tick */
+} PID_GAINS;
+
+extern PID_GAINS pidVoutBase;
+extern PID_GAINS pidIoutBase;
+extern uint16_t gsScaleV;          /* last applied scales, Q12 */
+extern uint16_t gsScaleI;
+
+extern uint16_t gs_lookup(const uint16_t (*table)[GS_V_POINTS], int32_t v_dV, int32_t i_dA);
+extern void gs_apply(int32_t v_dV, int32_t i_dA);
+extern void gs_set_base(PID_GAINS *base, int32_t kp, int32_t ki, uint16_t scale);
+
+#endif /* INC_GAINSCHED_H_ */
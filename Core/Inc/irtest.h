@@ -0,0 +1,67 @@
+/*
+ * irtest.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_IRTEST_H_
+#define INC_IRTEST_H_
+
+#include "main.h"
+
+/* DC internal resistance (PAGE_OUTPUT_CONTROL, charger mode). The current
+ * loop finds the DAC codes for testCurrent_dA and a quarter of it, then the
+ * DAC is held at the low code and stepped to the high one from the ADC block
+ * handler. V_BAT1 and I_DC2 of every ADC sequence around the step go into a
+ * RAM burst, the background fits V over I (least squares) in raw counts and
+ * converts the slope to micro-ohms. */
+
+#define IR_BURST            48      /* sequences captured, 1 ms each */
+#define IR_PRE              16      /* before the step (rounded up to a DMA block) */
+#define IR_HI_AVG           16      /* newest samples give the high current */
+#define IR_LOW_DIV          4       /* low current = testCurrent_dA / 4 */
+#define IR_SETTLE_TICKS     (1500u * OUT_CONTROL_RATE_HZ / 1000u)
+#define IR_SETTLE_TOL_dA    3       /* current loop must reach its reference */
+#define IR_CAPTURE_TICKS    (200u * OUT_CONTROL_RATE_HZ / 1000u)
+#define IR_V_MARGIN_dV      5       /* abort above the stage voltage + 0.5V */
+#define IR_MIN_STEP_dA      10      /* measured step below 1A: no result */
+
+typedef enum {
+	IRT_IDLE = 0,
+	IRT_SETTLE_HI,      /* current loop at the high current (tick) */
+	IRT_SETTLE_LO,      /* current loop at the low current (tick) */
+	IRT_CAPTURE,        /* DAC held, burst + step (ADC block handler) */
+	IRT_MEASURED,       /* burst full, fit pending (background) */
+	IRT_DONE,
+	IRT_FAILED
+} IrTestState_t;
+
+typedef struct
+{
+	volatile IrTestState_t state;
+	uint16_t iHigh_dA;
+	uint16_t iLow_dA;
+	int16_t  dacHigh;
+	int16_t  dacLow;
+	uint32_t ticks;
+	volatile uint8_t count;     /* samples in the burst */
+	uint8_t  stepIdx;           /* first sample after the step */
+	uint16_t vRaw[IR_BURST];
+	uint16_t iRaw[IR_BURST];
+
+	/* results */
+	uint16_t step_dA;           /* measured current step */
+	uint32_t r_uOhm;
+} IR_TEST;
+
+extern IR_TEST irTest;
+
+extern void irtest_start(void);
+extern void irtest_abort(void);
+extern uint8_t irtest_active(void);
+extern void irtest_sample(uint16_t iRaw, uint16_t vRaw, uint8_t remain);
+extern void irtest_tick(void);
+extern void irtest_update(void);
+
+#endif /* INC_IRTEST_H_ */
@@ -73,6 +73,7 @@
 #define PAGE_MFG_OFFSET    11  /**< Manufacturer Offset settings page */
 #define PAGE_MFG_LIMITS    12  /**< Manufacturer Max/Min values page */
 #define PAGE_MFG_MODE      13  /**< Manufacturer Device mode page */
+#define PAGE_MFG_TUNE      14  /**< Manufacturer PID autotune page */
 /**@}*/
 
 /**
@@ -121,6 +122,7 @@ extern uint8_t pageID;        /**< Current page ID */
 extern uint8_t buttonState;   /**< Button state bitfield */
 extern uint8_t lcdLangId;     /**< Language ID (0: EN, 1: TR) */
 extern uint8_t uiNeedsClear;  /**< UI refresh flag */
+extern uint8_t outputState;   /**< Output state shown on PAGE_MAIN, cleared by protect_trip() */
 extern OperatingMode operatingMode; /**< Current operating mode */
 extern uint8_t menuIndex;           /**< Current menu selection index */
 extern uint8_t subIndex;            /**< Current subpage selection index */
@@ -148,6 +150,9 @@ extern uint16_t mfgPinCode;          /**< Manufacturer PIN (default 0000) */
 extern uint8_t mfgPinInput[4];       /**< Current PIN entry digits */
 extern uint8_t mfgPinPos;            /**< Current cursor pos 0..3 for PIN */
 extern uint8_t mfgPinError;          /**< Last PIN state: 1 wrong */
+extern uint16_t vMax_dV;             /**< Device voltage maximum, 0.1V units */
+extern uint16_t iMax_dA;             /**< Device current maximum, 0.1A units */
+extern uint16_t tempMax;             /**< Heatsink temperature maximum, C */
 /**@}*/
 
 #endif /* INC_LCDMENU_H_ */
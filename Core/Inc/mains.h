@@ -0,0 +1,50 @@
+/*
+ * mains.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_MAINS_H_
+#define INC_MAINS_H_
+
+#include "main.h"
+#include "adc.h"
+
+/* Zero-cross locked mains analyser fed with adcBuffer[listVAC].
+ * A rising zero crossing is accepted only after the signal has been below
+ * -MAINS_HYST, so noise around zero cannot double-trigger. Sum of squares is
+ * integrated over MAINS_CYCLES whole cycles, the crossing instants are
+ * interpolated between samples for the frequency measurement. Works for
+ * 50/60 Hz at any ADC_SAMPLE_RATE_HZ. */
+#define MAINS_HYST    20  /* adcBuffer[listVAC] units */
+#define MAINS_CYCLES  5   /* cycles per published result */
+#define MAINS_MIN_HZ  40  /* slower than this is treated as no mains */
+#define MAINS_MAX_SAMPLES ((ADC_SAMPLE_RATE_HZ * MAINS_CYCLES) / MAINS_MIN_HZ)
+
+typedef struct
+{
+	/* ISR side, current window */
+	int64_t  sumSq;
+	uint32_t samples;
+	uint16_t startQ8;   /* crossing position before the first sample, Q8 */
+	int16_t  prev;
+	uint8_t  armed;
+	uint8_t  running;
+	uint8_t  cycles;
+
+	/* last complete window, read by mains_update() */
+	int64_t  pubSumSq;
+	uint32_t pubSamples;
+	uint32_t pubPeriodQ8; /* MAINS_CYCLES periods in samples, Q8 */
+	volatile uint8_t cycleComplete;
+	volatile uint8_t lost;
+} MAINS_METER;
+
+extern MAINS_METER mains;
+extern uint16_t mainsFreq_dHz;  /* line frequency, 0.1 Hz, 0 if no mains */
+
+extern void mains_sample(int16_t v);
+extern void mains_update(void);
+
+#endif /* INC_MAINS_H_ */
@@ -11,26 +11,63 @@
 #include "main.h"
 #include <stdint.h>
 #include "lcdMenu.h"  /* for OperatingMode enum */
+#include "pid.h"
 
-#define PID_VOUT_KP 15000
-#define PID_VOUT_KI 0
-#define PID_VOUT_KD 0
+/* Positional PID (pid.h), output = DAC code. The old velocity-form gains map
+ * as Kp -> KI (per tick) and the old +-200 output clamp -> SLEW.
+ * With a learned feed-forward model the integrators only hold the residual. */
+#define PID_DAC_MIN 0
+#define PID_DAC_MAX 4095
 
-#define PID_VOUT_OUT_MAX  200 //2000
-#define PID_VOUT_OUT_MIN -200 //0
+#define PID_VOUT_KP 0
+#define PID_VOUT_KI 15000
+#define PID_VOUT_KD 0
+#define PID_VOUT_SLEW 200
 
-#define PID_VOUT_INT_MAX  2000 //2000
-#define PID_VOUT_INT_MIN -2000 //0
+#define PID_VOUT_INT_MAX  (PID_DAC_MAX << PID_Q)
+#define PID_VOUT_INT_MIN  (-(PID_DAC_MAX << PID_Q))
 //-------------------------//
-#define PID_IOUT_KP 2000 // yuk bankasinda 10000
-#define PID_IOUT_KI 100
+/* The old I loop also added Ki = 100 times a running error sum (clamped to
+ * +-2000, up to 48 codes per tick) to the DAC, a second integrator. It is
+ * dropped on purpose: DAC to current is nearly static, the double integrator
+ * made the loop type 2 and only added overshoot to current steps. */
+#define PID_IOUT_KP 0
+#define PID_IOUT_KI 2000 // yuk bankasinda 10000
 #define PID_IOUT_KD 0
+#define PID_IOUT_SLEW 200
 
-#define PID_IOUT_OUT_MAX  200 //2000
-#define PID_IOUT_OUT_MIN -200 //0
+#define PID_IOUT_INT_MAX  (PID_DAC_MAX << PID_Q)
+#define PID_IOUT_INT_MIN  (-(PID_DAC_MAX << PID_Q))
 
-#define PID_IOUT_INT_MAX  1 //2000
-#define PID_IOUT_INT_MIN -1 //0
+#define PID_D_SHIFT    3    /* derivative filter, ~8 ticks */
+//-------------------------//
+/* Cascade outer voltage loop: output is the inner loop's current reference (0.1A) */
+#define PID_VOUTER_KP   16384   /* 4.0 dA per dV */
+#define PID_VOUTER_KI   4096    /* 1.0 dA per dV per outer update */
+#define PID_VOUTER_KD   0
+#define OUT_CASCADE_DIV 8       /* outer loop every 8 control ticks */
+//-------------------------//
+/* Supply constant-power limit: V*I excess (0.01W) >> shift integrates into a
+ * voltage reference foldback (Q8 dV) */
+#define OUT_PFOLD_SHIFT 8
+#define OUT_PMAX_W_MAX  1000
+//-------------------------//
+/* Control tick on TIM2, 1000..5000 Hz. Runs at NVIC priority 1 so the
+ * ADC/DMA block handlers (priority 0) can still preempt it. */
+#define OUT_CONTROL_RATE_HZ     1000
+#define OUT_CONTROL_BUDGET_PCT  50      /* tick budget, % of the period */
+#define OUT_CONTROL_IRQ_PRIO    1
+
+#if (OUT_CONTROL_RATE_HZ < 1000) || (OUT_CONTROL_RATE_HZ > 5000)
+#error "OUT_CONTROL_RATE_HZ must be 1000..5000"
+#endif
+//-------------------------//
+/* Soft start: V and I references slew toward their targets (ramp.h).
+ * 1 mV/ms = 1 V/s; 100 mV or mA per 0.1 unit gives the Q16 step per tick. */
+#define OUT_RAMP_V_DEFAULT  5       /* mV/ms */
+#define OUT_RAMP_I_DEFAULT  10      /* mA/ms */
+#define OUT_RAMP_MAX        100
+#define OUT_RAMP_Q16(perMs) ((int32_t)(perMs) * (655360 / OUT_CONTROL_RATE_HZ))
 
 /* Control parameters exposed to other modules */
 extern OperatingMode operatingMode;     /* MODE_CHARGER / MODE_SUPPLY */
@@ -38,35 +75,37 @@ extern uint8_t  batteryVoltageSel;      /* 0:12V, 1:24V */
 extern uint16_t batteryCapacityAh;      /* 1..999 Ah */
 extern uint8_t  batteryCount;           /* 1..24 */
 extern uint8_t  safeChargeOn;           /* 0/1 */
-extern uint8_t  softChargeOn;           /* 0/1 */
+extern uint8_t  softChargeOn;           /* 0/1, supply soft start */
 extern uint8_t  voltageEqualOn;         /* 0/1 */
 extern uint16_t testVoltage_dV;         /* 0.1V units */
 extern uint16_t testCurrent_dA;         /* 0.1A units */
 extern uint16_t outputVSet_dV;          /* 0.1V units */
 extern uint16_t outputIMax_dA;          /* 0.1A units */
+extern uint16_t outputPMax_W;           /* 1W units, supply mode */
+extern uint16_t outputVFold_dV;         /* present constant-power foldback */
 extern uint8_t  shortCircuitTest;       /* 0/1 */
+extern uint16_t rampV_mV_ms;            /* soft start slopes */
+extern uint16_t rampI_mA_ms;
 extern uint8_t deviceOn;
 
-typedef struct
-{
-    const  int Kp;
-    const  int Ki;
-    const  int Kd;
-
-    int setpoint;
-    int measured;
-
-    int error;
-    int prevError;
+/* Control tick statistics (DWT cycles) */
+extern volatile uint32_t ctrlTickCount;
+extern volatile uint32_t ctrlOverrunCount;
+extern volatile uint32_t ctrlCyclesLast;
+extern volatile uint32_t ctrlCyclesMax;
 
-    int integral;
-    int derivative;
-
-    int output;
+/* How the voltage and current loops share the DAC */
+typedef enum {
+    REG_STAGED = 0,     /* loops per charge stage (BULK: I, ABSORPTION: V, SAFE/EQL: both) */
+    REG_MIN_SELECT,     /* both loops every tick, lower DAC demand wins */
+    REG_CASCADE,        /* outer V loop (decimated) -> inner I loop -> DAC */
+    REG_MODE_COUNT
+} RegulationMode_t;
 
-    int outputMin;
-    int outputMax;
-}PIDController;
+typedef enum {
+    REG_LOOP_CC = 0,
+    REG_LOOP_CV
+} RegulationLoop_t;
 
 typedef enum {
     STATE_BULK,
@@ -82,6 +121,7 @@ typedef struct
 {
     unsigned int batteryVoltage;
     unsigned int batteryCap;
+    unsigned char profile;              /* BatteryProfile_t */
     unsigned int numberOfBattery;
     unsigned int bulkCurrent;
     unsigned int floatVoltage;
@@ -90,7 +130,7 @@ typedef struct
     unsigned int storageVoltage;
     unsigned int safeVoltage;
     unsigned int safeStepMV;
-    unsigned char softChargeEnabled;
+    unsigned char softChargeEnabled;    /* charger soft start */
     unsigned char safeChargeEnabled;
     unsigned char equalizationEnabled;
     ChargeState_t chargeState;
@@ -101,10 +141,14 @@ typedef struct
 }BATTERY_INFO;
 
 extern BATTERY_INFO batInfo;
-extern PIDController pidVout;
-extern PIDController pidIout;
+extern RegulationMode_t regulationMode;
+extern volatile RegulationLoop_t regActiveLoop;
+extern PID_CONTROLLER pidVout;
+extern PID_CONTROLLER pidIout;
+extern PID_CONTROLLER pidVouter;
 
-extern int PID_Compute(PIDController *pid, unsigned long setpoint, unsigned long measured);
 extern void outCalculation();
+extern void outControlStart(void);
+extern void outControlTick(void);
 
 #endif /* INC_OUT_CONTROL_H_ */
@@ -0,0 +1,54 @@
+/*
+ * pid.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_PID_H_
+#define INC_PID_H_
+
+#include "main.h"
+
+/* Positional fixed-point PID for the control tick.
+ * Gains are Q12, the integrator and the derivative state are Q12 in output
+ * units, so ki * error adds directly to the integrator every update. */
+
+#define PID_Q        12
+#define PID_ONE      (1 << PID_Q)
+
+typedef enum {
+	PID_AW_CLAMP = 0,       /* integrator held inside intMin..intMax */
+	PID_AW_BACKCALC         /* integrator pulled back by kb * (applied - unsaturated) */
+} PID_AW_MODE;
+
+typedef struct
+{
+	/* parameters */
+	int32_t kp;             /* Q12 */
+	int32_t ki;             /* Q12, per update */
+	int32_t kd;             /* Q12, per update */
+	int32_t kb;             /* Q12, back-calculation gain */
+	PID_AW_MODE awMode;
+	uint8_t dShift;         /* derivative filter, d += (raw - d) >> dShift */
+
+	int32_t intMin;         /* Q12 output units */
+	int32_t intMax;
+	int16_t outMin;
+	int16_t outMax;
+	int16_t slewMax;        /* max output step per update, 0: off */
+
+	int16_t feedForward;    /* output units, added before saturation */
+
+	/* state */
+	int32_t integral;       /* Q12 */
+	int32_t dState;         /* Q12, filtered -d(measured) */
+	int32_t prevMeasured;
+	int16_t output;         /* last applied output */
+} PID_CONTROLLER;
+
+extern int16_t pid_update(PID_CONTROLLER *pid, int32_t setpoint, int32_t measured);
+extern void pid_prime(PID_CONTROLLER *pid, int32_t setpoint, int32_t measured, int16_t output);
+extern void pid_track(PID_CONTROLLER *pid, int32_t setpoint, int32_t measured, int16_t output);
+
+#endif /* INC_PID_H_ */
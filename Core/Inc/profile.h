@@ -0,0 +1,50 @@
+/*
+ * profile.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_PROFILE_H_
+#define INC_PROFILE_H_
+
+#include "main.h"
+
+/* Battery chemistry profiles in flash. Voltages are per 12V block in mV,
+ * built from per-cell values at compile time; currents are 1/1000 C.
+ * profile_apply() scales them into batInfo with integer math only. */
+
+#define PROF_LEAD_CELLS     6
+#define PROF_LFP_CELLS      4
+
+#define PROF_LEAD(cell_mV)  ((cell_mV) * PROF_LEAD_CELLS)
+#define PROF_LFP(cell_mV)   ((cell_mV) * PROF_LFP_CELLS)
+
+typedef enum {
+	PROF_FLOODED = 0,
+	PROF_AGM,
+	PROF_GEL,
+	PROF_CALCIUM,
+	PROF_LIFEPO4,
+	PROF_COUNT
+} BatteryProfile_t;
+
+typedef struct
+{
+	uint16_t absorption_mV;     /* per 12V block */
+	uint16_t float_mV;
+	uint16_t storage_mV;
+	uint16_t safe_mV;
+	uint16_t bulk_mC;           /* bulk current, 1/1000 C */
+	uint16_t finish_mC;         /* absorption tail current, 1/1000 C */
+	uint8_t  equalization;
+	uint8_t  safeCharge;
+	uint8_t  cells;             /* per 12V block */
+	int8_t   tcomp_dmV;         /* 0.1mV / C / cell, tempcomp.h */
+} BATTERY_PROFILE;
+
+extern const BATTERY_PROFILE batteryProfiles[PROF_COUNT];
+
+extern void profile_apply(void);
+
+#endif /* INC_PROFILE_H_ */
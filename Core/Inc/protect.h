@@ -0,0 +1,78 @@
+/*
+ * protect.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_PROTECT_H_
+#define INC_PROTECT_H_
+
+#include "main.h"
+
+#define PROTECT_OC_MARGIN_dA   5   /* AWD above the supply CC limit, 0.1A units */
+
+/* Short circuit: I_DC2 rise between two ADC sequences (or the AWD limit)
+ * together with V_BAT1 below a fraction of its pre-fault value.
+ * Latency: only currents above protectOcRaw trip per conversion (AWD). The
+ * rise/collapse test looks at every sequence, but runs when the DMA half is
+ * handed over, so a short in the oldest sequence of a block trips
+ * ADC_DMA_SEQ_PER_HALF sequences (4 ms) after it was sampled; tripTime_us
+ * reports that delay. */
+#define SC_DI_dA            50      /* rise per sequence, 0.1A units */
+#define SC_VCOLLAPSE_SHIFT  1       /* collapse below filtered VBAT >> 1 */
+#define SC_RECOVER_PCT      90      /* recovered at this % of the pre-fault VBAT */
+#define SC_RECOVER_MS       2000    /* hiccup restart must recover within this + the V ramp */
+#define SC_AWD_WINDOW       2       /* sequences after an AWD trip checked for a collapse */
+#define SC_TEST_WAIT_MS     10000   /* test gives up if no short is applied */
+#define SC_OFF_MS_DEFAULT   1000
+#define SC_RETRY_DEFAULT    3
+
+/* Latched fault codes, shown on PAGE_MAIN until the output is switched on again */
+typedef enum {
+    FAULT_NONE = 0,
+    FAULT_OVERCURRENT,      /* ADC1 analog watchdog on I_DC2 */
+    FAULT_SHORT,            /* short circuit, hiccup retries */
+    FAULT_BAT_SHORT,        /* SAFE stage: current flows, battery voltage stays down */
+    FAULT_BAT_OPEN,         /* SAFE stage: no current at the probe ceiling, or no battery */
+    FAULT_COUNT
+} FaultCode_t;
+
+/* Automated short-circuit test (PAGE_OUTPUT_CONTROL, supply mode) */
+typedef enum {
+    SCT_IDLE = 0,
+    SCT_WAIT_SHORT,         /* output on, waiting for the fixture short */
+    SCT_HICCUP,             /* tripped, retrying */
+    SCT_DONE,               /* recovered after the short was removed */
+    SCT_FAILED,             /* retries used up */
+    SCT_TIMEOUT             /* no short seen */
+} ScTestState_t;
+
+typedef struct
+{
+    volatile ScTestState_t state;
+    uint16_t peakRaw;       /* I_DC2 peak, raw counts (ISR) */
+    uint16_t peak_dA;       /* peakRaw through the IDC2 curve (background) */
+    uint16_t tripTime_us;   /* newest sample of the event to output off */
+    uint16_t recovery_ms;   /* restart to VBAT back at SC_RECOVER_PCT */
+    uint8_t  attempts;      /* hiccup restarts used */
+    uint32_t ticks;
+} SC_TEST_RESULT;
+
+extern volatile FaultCode_t faultCode;
+extern uint16_t protectOcRaw;   /* AWD high threshold, raw I_DC2 counts */
+extern uint16_t scOffTime_ms;   /* hiccup off-time */
+extern uint8_t  scRetryMax;     /* hiccup attempts before the fault latches */
+extern SC_TEST_RESULT scTest;
+
+extern void protect_init(void);
+extern void protect_update_limits(void);
+extern void protect_trip(FaultCode_t code);
+extern void protect_clear(void);
+extern void protect_adc_irq(void);
+extern void protect_sc_sample(uint16_t iRaw, uint16_t vRaw, uint8_t remain, uint8_t seq);
+extern void protect_tick(void);
+extern void protect_sc_test_start(void);
+extern void protect_sc_cancel(void);
+
+#endif /* INC_PROTECT_H_ */
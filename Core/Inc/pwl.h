@@ -0,0 +1,47 @@
+/*
+ * pwl.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_PWL_H_
+#define INC_PWL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Piecewise-linear calibration table. Breakpoints must be sorted by x,
+ * tables are normally const (flash); a table may live in RAM when its
+ * y values are derived from editable gains. Inputs outside the table are
+ * clamped to the first/last point, results are rounded to nearest.
+ * Tables read in the control tick keep Q16 segment slopes in RAM, rebuilt
+ * by pwl_update_slopes() after the points change, so a lookup is a
+ * multiply and a shift; the others divide per lookup. */
+
+#define PWL_SLOPE_Q  16
+
+typedef struct
+{
+	int16_t x;
+	int16_t y;
+} PWL_POINT;
+
+typedef struct
+{
+	const PWL_POINT *pt;
+	int32_t *slope;         /* count - 1 segments, Q16 dy/dx; NULL: divide */
+	uint8_t count;
+} PWL_TABLE;
+
+#define PWL_TABLE_INIT(points) \
+	{ (points), NULL, (uint8_t)(sizeof(points) / sizeof((points)[0])) }
+#define PWL_TABLE_INIT_SLOPE(points, slopes) \
+	{ (points), (slopes), (uint8_t)(sizeof(points) / sizeof((points)[0])) }
+
+extern int16_t pwl_interp(const PWL_TABLE *t, int32_t x);
+extern int32_t pwl_interp_q(const PWL_TABLE *t, int32_t x, uint8_t frac);
+extern int32_t pwl_inverse(const PWL_TABLE *t, int32_t y);
+extern void pwl_update_slopes(const PWL_TABLE *t);
+
+#endif /* INC_PWL_H_ */
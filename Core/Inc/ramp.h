@@ -0,0 +1,29 @@
+/*
+ * ramp.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_RAMP_H_
+#define INC_RAMP_H_
+
+#include "main.h"
+
+/* Setpoint slew-rate generator for the control tick. The reference moves
+ * toward its target by a fixed Q16 step per tick, so slopes well below one
+ * unit per tick (0.1V or 0.1A) still advance. */
+
+#define RAMP_Q      16
+
+typedef struct
+{
+	int32_t value;      /* present reference, Q16 target units */
+	int32_t step;       /* Q16 per tick, 0: follow the target at once */
+} RAMP;
+
+extern void ramp_reset(RAMP *r, int32_t value);
+extern int32_t ramp_step(RAMP *r, int32_t target, uint8_t hold);
+extern int32_t ramp_value(const RAMP *r);
+
+#endif /* INC_RAMP_H_ */
@@ -0,0 +1,37 @@
+/*
+ * slope.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_SLOPE_H_
+#define INC_SLOPE_H_
+
+#include "main.h"
+
+/* Least-squares slope over consecutive windows of SLOPE_N samples, kept as
+ * running sums (sum y, sum t*y) so each sample is O(1) and no samples are
+ * stored. With t = 0..N-1 the t sums are constants:
+ * slope = (N sum(t y) - sum(t) sum(y)) / SLOPE_DEN. The numerator and
+ * the window mean are published when a window closes, callers compare the
+ * numerator against threshold * SLOPE_DEN instead of dividing. */
+
+#define SLOPE_N         60
+#define SLOPE_SUM_T     ((int32_t)SLOPE_N * (SLOPE_N - 1) / 2)
+#define SLOPE_DEN       ((int32_t)SLOPE_N * SLOPE_N * (SLOPE_N * SLOPE_N - 1) / 12)
+
+typedef struct
+{
+	uint8_t n;          /* samples in the open window */
+	uint8_t valid;      /* num holds a closed window */
+	int32_t sy;
+	int32_t sty;
+	int32_t num;        /* slope * SLOPE_DEN, units per sample */
+	int32_t mean;       /* window average */
+} SLOPE;
+
+extern void slope_reset(SLOPE *s);
+extern uint8_t slope_add(SLOPE *s, int32_t y);
+
+#endif /* INC_SLOPE_H_ */
@@ -0,0 +1,35 @@
+/*
+ * soc.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_SOC_H_
+#define INC_SOC_H_
+
+#include "main.h"
+
+/* State of charge by coulomb counting. The control tick adds I_DC2 (0.1A)
+ * times a per-tick weight into a 64-bit Q40 per-mille accumulator; the
+ * weight (1000 / capacity in 0.1A ticks, charge efficiency included) is
+ * computed in the background when batteryCap changes. While the current
+ * stays near zero the background pulls the count toward the resting
+ * open-circuit voltage table of the chemistry. */
+
+#define SOC_Q               40
+#define SOC_FULL            1000            /* per mille */
+#define SOC_CHARGE_EFF_PCT  95
+#define SOC_REST_dA         2               /* near zero below 0.2A */
+#define SOC_REST_S          600             /* OCV is trusted after 10 min */
+#define SOC_OCV_SHIFT       2               /* 1/4 of the OCV error per minute */
+#define SOC_TTF_UNKNOWN     0xFFFF
+#define SOC_SEED_MS         1000            /* after reset, V_BAT1 filter settled */
+
+extern uint16_t socPermille;        /* 0..1000, published by the tick */
+extern uint16_t socTimeToFull_min;  /* charger, SOC_TTF_UNKNOWN if not charging */
+
+extern void soc_tick(void);
+extern void soc_update(void);
+
+#endif /* INC_SOC_H_ */
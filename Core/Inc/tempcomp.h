@@ -0,0 +1,37 @@
+/*
+ * tempcomp.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_TEMPCOMP_H_
+#define INC_TEMPCOMP_H_
+
+#include "main.h"
+
+/* Temperature compensation of the charge voltages. The offset for the whole
+ * string (profile coefficient x cells x (T - 25C)) is tabulated in 2C steps
+ * from -20C to 60C, both in 0.1V and in raw V_BAT1 counts, and rebuilt only
+ * when the profile, the string or the V_BAT1 gain changes. Outside the
+ * table range the end entries apply.
+ * The board has no battery-side sensor: the table is indexed with the
+ * ambient estimate of the heatsink model (thermalAmbient_C), not with the
+ * heatsink NTC, so converter self-heating does not lower the voltages.
+ * A battery warmer than the air (its own charge losses, a warm enclosure)
+ * is under-compensated by that difference. */
+
+#define TC_T_MIN            (-20)
+#define TC_T_MAX            60
+#define TC_T_SHIFT          1       /* 2C per entry */
+#define TC_T_REF            25
+#define TC_POINTS           (((TC_T_MAX - TC_T_MIN) >> TC_T_SHIFT) + 1)
+#define TC_CLAMP_mV_CELL    150     /* offset limit per cell, either direction */
+
+extern int16_t tcLut_dV[TC_POINTS];
+extern int16_t tcLutRaw[TC_POINTS];
+
+extern void tc_build(void);
+extern uint8_t tc_index(int16_t t_C);
+
+#endif /* INC_TEMPCOMP_H_ */
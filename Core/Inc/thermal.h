@@ -0,0 +1,38 @@
+/*
+ * thermal.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef INC_THERMAL_H_
+#define INC_THERMAL_H_
+
+#include "main.h"
+
+/* Heatsink first-order RC model, stepped once per second in the background.
+ * Losses are estimated from the output power, the model rise above ambient
+ * is tracked in Q8 C and the ambient estimate is corrected against the TEMP
+ * NTC. The temperature predicted TH_PREDICT_S ahead scales the current
+ * targets down before tempMax is reached. */
+
+#define TH_Q                8
+#define TH_LOSS_PCT         11      /* converter loss, % of the output power */
+#define TH_LOSS_FIXED_cW    300     /* bias, fans, control: 3W */
+#define TH_RTH_Q8           256     /* heatsink to ambient, 1.0 C/W */
+#define TH_TAU_SHIFT        8       /* time constant 256 s */
+#define TH_OBS_SHIFT        3       /* ambient correction, ~8 s */
+#define TH_PREDICT_S        128
+#define TH_PREDICT_Q12      2484    /* exp(-TH_PREDICT_S / 256 s) */
+#define TH_MARGIN_C         10      /* derating starts this far below tempMax */
+#define TH_SCALE_MIN        64      /* Q8, 25% of the current target */
+#define TH_SCALE_DOWN       8       /* Q8 per second */
+#define TH_SCALE_UP         2
+
+extern uint16_t thermalScale_q8;        /* current target scale, 256 = none */
+extern int16_t  thermalPredict_C;       /* heatsink TH_PREDICT_S ahead */
+extern int16_t  thermalAmbient_C;       /* ambient estimate, feeds tempcomp */
+
+extern void thermal_update(void);
+
+#endif /* INC_THERMAL_H_ */
@@ -6,23 +6,16 @@
  */
 
 #include "adc.h"
+#include "adc_filter.h"
+#include "mains.h"
+#include "protect.h"
+#include "irtest.h"
+#include "eis.h"
 
 // ADC BUFFER VAR
-q15_t adc1Buffer[ADC1_CHANNEL_COUNT];
+q15_t adc1Buffer[ADC_DMA_SEQ_COUNT][ADC1_CHANNEL_COUNT];
 int16_t adcBuffer[ADC1_CHANNEL_COUNT];
 
-// ADC MEAN VAR
-
-q15_t adcMeanBuffer[ADC1_CHANNEL_COUNT][ADC_MEAN_BUFFER_SIZE];
-int32_t adcMeanSum[ADC_MEAN_CHANNEL_COUNT];
-uint8_t adcMeanBufferPo = 0;
-
-// ADC RMS VAR
-
-int32_t adcRmsBuffer[ADC_RMS_BUFFER_SIZE];
-int64_t adcRmsSum;
-uint8_t adcRmsBufferPo;
-
 uint16_t adcVAC = 0;
 uint16_t adcTEMP = 0;
 uint16_t adcIDC = 0;
@@ -31,14 +24,43 @@ uint16_t adcVDC1 = 0;
 uint16_t adcVDC2 = 0;
 uint16_t adcIDC2NoGain = 0;
 uint16_t adcIDC2 = 0;
-uint8_t temp;
+int16_t temp;
 
 int16_t adcGain[ADC1_CHANNEL_COUNT + 3];
 uint16_t dcOffset = 1985;
 
+/* NTC: raw TEMP counts -> degC. Points follow the former five linear fits,
+ * averaged where neighbouring fits disagreed at the boundary. */
+static const PWL_POINT ntcTempPoints[] =
+{
+	{ 1600, -30 },
+	{ 3124,  33 },
+	{ 3289,  41 },
+	{ 3545,  61 },
+	{ 3786,  82 },
+	{ 4095,  97 },
+};
+const PWL_TABLE ntcTempCurve = PWL_TABLE_INIT(ntcTempPoints);
+
+/* IDC2: raw counts -> dA, read every control tick. y and the segment slopes
+ * are rebuilt from the editable adcGain[listIDC2..+3] by
+ * adc_idc2_curve_update(), x breakpoints are fixed: the middle of each gain
+ * segment, the curve runs through x * gain there. */
+static PWL_POINT adcIdc2Points[IDC2_CURVE_POINTS] =
+{
+	{ 0, 0 },
+	{ IDC2_SEG0_MAX / 2, 0 },
+	{ (IDC2_SEG0_MAX + IDC2_SEG1_MAX) / 2, 0 },
+	{ (IDC2_SEG1_MAX + IDC2_SEG2_MAX) / 2, 0 },
+	{ (IDC2_SEG2_MAX + IDC2_ADC_MAX) / 2, 0 },
+	{ IDC2_ADC_MAX, 0 }
+};
+static int32_t adcIdc2Slope[IDC2_CURVE_POINTS - 1];
+const PWL_TABLE adcIdc2Curve = PWL_TABLE_INIT_SLOPE(adcIdc2Points, adcIdc2Slope);
+
 void adc_init(void)
 {
-	adcGain[listVAC]   = 9100;
+	adcGain[listVAC]   = 9592;   /* 9100 * sqrt(20 / 18), see mains_update() */
 	adcGain[listTEMP]  = Q15(1);
 	adcGain[listIDC]   = 2500;
 	adcGain[listVBAT1] = 2500;
@@ -49,18 +71,22 @@ void adc_init(void)
 	adcGain[listIDC2 + 2]  = 3300;
 	adcGain[listIDC2 + 3]  = 2575;
 
+	adc_idc2_curve_update();
+	adc_filter_init();
+
     LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_1);
     LL_DMA_SetPeriphAddress(DMA1, LL_DMA_CHANNEL_1,
     LL_ADC_DMA_GetRegAddr(ADC1, LL_ADC_DMA_REG_REGULAR_DATA));
     LL_DMA_SetMemoryAddress(DMA1, LL_DMA_CHANNEL_1, (uint32_t)adc1Buffer);
-    LL_DMA_SetDataLength(DMA1, LL_DMA_CHANNEL_1, ADC1_CHANNEL_COUNT);
+    LL_DMA_SetDataLength(DMA1, LL_DMA_CHANNEL_1, ADC_DMA_SEQ_COUNT * ADC1_CHANNEL_COUNT);
     LL_DMA_SetPeriphIncMode(DMA1, LL_DMA_CHANNEL_1, LL_DMA_PERIPH_NOINCREMENT);
     LL_DMA_SetMemoryIncMode(DMA1, LL_DMA_CHANNEL_1, LL_DMA_MEMORY_INCREMENT);
     LL_DMA_SetPeriphSize(DMA1, LL_DMA_CHANNEL_1, LL_DMA_PDATAALIGN_HALFWORD);
     LL_DMA_SetMemorySize(DMA1, LL_DMA_CHANNEL_1, LL_DMA_MDATAALIGN_HALFWORD);
     LL_DMA_SetMode(DMA1, LL_DMA_CHANNEL_1, LL_DMA_MODE_CIRCULAR);
     LL_DMA_SetDataTransferDirection(DMA1, LL_DMA_CHANNEL_1, LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
-    LL_DMA_EnableIT_TC(DMA1, LL_DMA_CHANNEL_1); // opsiyonel: NVIC enable da yap
+    LL_DMA_EnableIT_HT(DMA1, LL_DMA_CHANNEL_1); // ilk yari hazir
+    LL_DMA_EnableIT_TC(DMA1, LL_DMA_CHANNEL_1); // ikinci yari hazir
     LL_DMA_EnableChannel(DMA1, LL_DMA_CHANNEL_1);
 
     LL_ADC_Enable(ADC1);
@@ -69,26 +95,73 @@ void adc_init(void)
     LL_ADC_REG_StartConversionSWStart(ADC1);
 }
 
-void calculationTemp(uint16_t adcValue)
+/* Called from DMA1_Channel1_IRQHandler with one half of adc1Buffer.
+ * adcBuffer[] holds the last sequence of the block when it returns. */
+void adc_process_block(const q15_t (*seq)[ADC1_CHANNEL_COUNT], uint8_t count)
 {
-	if (adcValue < 3124)
+	for (uint8_t n = 0; n < count; n++)
 	{
-		temp = ((adcValue * M1) >>15) + C1;
-	}
-	else if ( adcValue < 3289)
-	{
-		temp = ((adcValue * M2) >>15) + C2;
+		const q15_t *raw = seq[n];
+
+		/* VAC */
+		adcBuffer[listVAC] = (q15_t)(((int32_t)(raw[listVAC] - dcOffset) * adcGain[listVAC]) >> 15);
+		mains_sample(adcBuffer[listVAC]);
+
+		/* TEMP, IDC, VBAT1, VDC1, VDC2, IDC2: filtered as raw counts */
+		for (uint8_t ch = listTEMP; ch <= listIDC2; ch++)
+		{
+			adc_filter_update(ch, raw[ch]);
+		}
+
+		/* Short circuit: every sequence is checked, at block latency (protect.h) */
+		protect_sc_sample(raw[listIDC2], raw[listVBAT1], count - 1 - n, (uint8_t)(seq + n - adc1Buffer));
+		irtest_sample(raw[listIDC2], raw[listVBAT1], count - 1 - n);
+		eis_sample(raw[listIDC2], raw[listVBAT1]);
 	}
-	else if (adcValue < 3545)
+
+	/* Instantaneous values from the newest sequence of the block */
 	{
-		temp = ((adcValue * M3) >>15) + C3;
+		const q15_t *raw = seq[count - 1];
+
+		for (uint8_t ch = listTEMP; ch < listIDC2; ch++)
+		{
+			adcBuffer[ch] = (q15_t)(((int32_t)(raw[ch]) * adcGain[ch]) >> 15);
+		}
+		/* IDC2: gain is applied segment-wise in main() */
+		adcBuffer[listIDC2] = raw[listIDC2];
 	}
-	else if (adcValue < 3786)
+}
+
+/* The segment gains scale x through the origin, so the old per-range
+ * readings are kept at the segment middles. y never falls: the thresholds
+ * come from pwl_inverse(), which needs an increasing curve. */
+void adc_idc2_curve_update(void)
+{
+	int16_t y[IDC2_CURVE_POINTS];
+
+	y[0] = 0;
+	for (uint8_t i = 1; i < IDC2_CURVE_POINTS; i++)
 	{
-		temp = ((adcValue * M4) >>15) + C4;
+		uint8_t seg = (i < 4u) ? (uint8_t)(i - 1u) : 3u;
+
+		y[i] = (int16_t)(((int32_t)adcIdc2Points[i].x * adcGain[listIDC2 + seg]) >> 15);
+		if (y[i] < y[i - 1u])
+		{
+			y[i] = y[i - 1u];
+		}
 	}
-	else
+
+	/* Points and slopes change together for the tick and the ISR */
+	__disable_irq();
+	for (uint8_t i = 0; i < IDC2_CURVE_POINTS; i++)
 	{
-		temp = ((adcValue * M5) >>15) + C5;
+		adcIdc2Points[i].y = y[i];
 	}
+	pwl_update_slopes(&adcIdc2Curve);
+	__enable_irq();
+}
+
+void calculationTemp(uint16_t adcValue)
+{
+	temp = pwl_interp(&ntcTempCurve, adcValue);
 }
@@ -0,0 +1,47 @@
+/*
+ * adc_filter.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "adc_filter.h"
+
+ADC_FILTER adcFilter[ADC_MEAN_CHANNEL_COUNT];
+
+const uint8_t adcFilterShift[ADC_MEAN_CHANNEL_COUNT] =
+{
+	[listTEMP  - 1] = ADC_FILTER_K_TEMP,
+	[listIDC   - 1] = ADC_FILTER_K_IDC,
+	[listVBAT1 - 1] = ADC_FILTER_K_VBAT1,
+	[listVDC1  - 1] = ADC_FILTER_K_VDC1,
+	[listVDC2  - 1] = ADC_FILTER_K_VDC2,
+	[listIDC2  - 1] = ADC_FILTER_K_IDC2,
+};
+
+void adc_filter_init(void)
+{
+	for (uint8_t i = 0; i < ADC_MEAN_CHANNEL_COUNT; i++)
+	{
+		adcFilter[i].s1 = 0;
+		adcFilter[i].s2 = 0;
+	}
+}
+
+/* Filtered raw ADC counts (0..4095), rounded */
+uint16_t adc_filter_out(uint8_t ch)
+{
+	int32_t s = adcFilter[ch - 1].s2;
+
+	if (s < 0)
+	{
+		return 0;
+	}
+	return (uint16_t)((s + (1 << (ADC_FILTER_FRAC - 1))) >> ADC_FILTER_FRAC);
+}
+
+/* Filtered value with the channel gain applied, same units as adcBuffer[ch] */
+uint16_t adc_filter_scaled(uint8_t ch)
+{
+	return (uint16_t)(((int32_t)adc_filter_out(ch) * adcGain[ch]) >> 15);
+}
@@ -0,0 +1,150 @@
+/*
+ * autotune.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "autotune.h"
+#include "out_control.h"
+#include "gainsched.h"
+
+/* Ziegler-Nichols PI from the relay describing function Ku = 4d / (pi a):
+ * kp = 0.45 Ku, ki = 0.54 Ku / Tu. With a = ampSum / (2N) and Tu = periodSum / N:
+ * kp(Q12) = AT_KP_NUM * N d / ampSum, ki(Q12) = AT_KI_NUM * N^2 d / (ampSum periodSum) */
+#define AT_KP_NUM   4694    /* 0.45 * 8/pi * 4096 */
+#define AT_KI_NUM   5632    /* 0.54 * 8/pi * 4096 */
+#define AT_KU_NUM   41      /* 8/pi * 16, Ku in Q4 */
+
+AUTOTUNE autotune = { .state = AT_IDLE };
+
+/* Background: relay around the present operating point (setpoint = measured) */
+void autotune_start(AutotuneLoop_t loop, int32_t setpoint, int16_t center)
+{
+	AUTOTUNE *at = &autotune;
+
+	at->state = AT_IDLE;
+	if (center < PID_DAC_MIN + AT_RELAY_D)
+	{
+		center = PID_DAC_MIN + AT_RELAY_D;
+	}
+	else if (center > PID_DAC_MAX - AT_RELAY_D)
+	{
+		center = PID_DAC_MAX - AT_RELAY_D;
+	}
+	at->loop = loop;
+	at->setpoint = setpoint;
+	at->center = center;
+	at->high = 1;
+	at->cycles = 0;
+	at->ticks = 0;
+	at->lastRise = 0;
+	at->periodSum = 0;
+	at->ampSum = 0;
+	at->yMax = setpoint;
+	at->yMin = setpoint;
+	at->state = AT_RUNNING;
+}
+
+void autotune_abort(void)
+{
+	if (autotune_active())
+	{
+		autotune.state = AT_ABORTED;
+	}
+}
+
+uint8_t autotune_active(void)
+{
+	return (autotune.state == AT_RUNNING || autotune.state == AT_MEASURED);
+}
+
+/* Control tick: relay output for this tick */
+int16_t autotune_step(int32_t measured)
+{
+	AUTOTUNE *at = &autotune;
+
+	if (at->state != AT_RUNNING)
+	{
+		return at->center;
+	}
+	at->ticks++;
+	if (measured > at->setpoint + AT_MAX_DEV || measured < at->setpoint - AT_MAX_DEV
+		|| at->ticks > AT_TIMEOUT_TICKS)
+	{
+		at->state = AT_ABORTED;
+		return at->center;
+	}
+
+	if (measured > at->yMax)
+	{
+		at->yMax = measured;
+	}
+	if (measured < at->yMin)
+	{
+		at->yMin = measured;
+	}
+
+	if (at->high && measured > at->setpoint + AT_HYST)
+	{
+		at->high = 0;
+	}
+	else if (!at->high && measured < at->setpoint - AT_HYST)
+	{
+		/* Rising relay edge closes one limit cycle */
+		at->high = 1;
+		if (at->lastRise != 0)
+		{
+			at->cycles++;
+			if (at->cycles > AT_SKIP_CYCLES)
+			{
+				at->periodSum += at->ticks - at->lastRise;
+				at->ampSum += at->yMax - at->yMin;
+			}
+			if (at->cycles == AT_SKIP_CYCLES + AT_MEAS_CYCLES)
+			{
+				at->state = AT_MEASURED;
+				return at->center;
+			}
+		}
+		at->lastRise = at->ticks;
+		at->yMax = measured;
+		at->yMin = measured;
+	}
+	return (int16_t)(at->center + (at->high ? AT_RELAY_D : -AT_RELAY_D));
+}
+
+/* Background: gains from the measured cycles into the RAM schedule base
+ * gains, the loops pick them up through gs_apply() */
+void autotune_update(void)
+{
+	AUTOTUNE *at = &autotune;
+	int64_t nd;
+
+	if (at->state != AT_MEASURED)
+	{
+		return;
+	}
+	if (at->ampSum <= 0 || at->periodSum == 0)
+	{
+		at->state = AT_ABORTED;
+		return;
+	}
+
+	nd = (int64_t)AT_MEAS_CYCLES * AT_RELAY_D;
+	at->kp = (int32_t)(AT_KP_NUM * nd / at->ampSum);
+	at->ki = (int32_t)(AT_KI_NUM * nd * AT_MEAS_CYCLES / ((int64_t)at->ampSum * at->periodSum));
+	at->ku_q4 = (uint16_t)(AT_KU_NUM * nd / at->ampSum);
+	at->tu_ms = (uint16_t)((uint64_t)at->periodSum * 1000u / (AT_MEAS_CYCLES * OUT_CONTROL_RATE_HZ));
+
+	/* Tuned at the present schedule point, stored unscaled */
+	if (at->loop == AT_LOOP_V)
+	{
+		gs_set_base(&pidVoutBase, at->kp, at->ki, gsScaleV);
+	}
+	else
+	{
+		gs_set_base(&pidIoutBase, at->kp, at->ki, gsScaleI);
+	}
+	at->state = AT_DONE;
+}
@@ -0,0 +1,426 @@
+/*
+ * charge.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "charge.h"
+#include "adc.h"
+#include "adc_filter.h"
+#include "tempcomp.h"
+#include "lcdMenu.h"
+#include "profile.h"
+#include "protect.h"
+#include "thermal.h"
+
+/* Indexed by ChargeState_t */
+static const CHARGE_STAGE chargeTable[] = {
+	/* STATE_BULK */
+	{ CHG_LOOP_CC,   CHG_SP_ABS_V,   CHG_SP_BULK_I, CHG_EXIT_V_ABOVE, CHG_TH_ABS_V,    STATE_ABSORPTION,    720,   STATE_ABSORPTION },
+	/* STATE_BATTERY_SAFE */
+	{ CHG_LOOP_CVCC, CHG_SP_SAFE_V,  CHG_SP_SAFE_I, CHG_EXIT_SAFE,    CHG_TH_DEEP_V,   STATE_BULK,          120,   CHG_NEXT_OFF },
+	/* STATE_ABSORPTION */
+	{ CHG_LOOP_CV,   CHG_SP_ABS_V,   CHG_SP_BULK_I, CHG_EXIT_TAPER,   CHG_TH_FINISH_I, STATE_EQUALIZATION,  480,   STATE_EQUALIZATION },
+	/* STATE_EQUALIZATION */
+	{ CHG_LOOP_CVCC, CHG_SP_EQL_V,   CHG_SP_EQL_I,  CHG_EXIT_NONE,    CHG_TH_NONE,     STATE_FLOAT,         180,   STATE_FLOAT },
+	/* STATE_FLOAT */
+	{ CHG_LOOP_CV,   CHG_SP_FLOAT_V, CHG_SP_BULK_I, CHG_EXIT_V_BELOW, CHG_TH_REBULK_V, STATE_BULK,          1440,  STATE_STORAGE },
+	/* STATE_STORAGE */
+	{ CHG_LOOP_CV,   CHG_SP_STORE_V, CHG_SP_BULK_I, CHG_EXIT_V_BELOW, CHG_TH_STORE_V,  STATE_BULK,          10080, STATE_REFRESH },
+	/* STATE_REFRESH */
+	{ CHG_LOOP_CV,   CHG_SP_ABS_V,   CHG_SP_BULK_I, CHG_EXIT_NONE,    CHG_TH_NONE,     STATE_STORAGE,       60,    STATE_STORAGE },
+};
+
+uint16_t chargeSetpoint[CHG_SP_COUNT];
+uint16_t chargeThRaw[CHG_TH_COUNT];
+uint16_t chargeStageMinutes = 0;
+SLOPE chargeSlopeV;
+SLOPE chargeSlopeI;
+
+static uint32_t chargeTicks = 0;
+static uint16_t chargeHold = 0;
+
+/* Absorption end: window slope limits (slope numerators) and passing windows */
+static uint16_t chargeSlopeTicks = 0;
+static uint8_t  chargeTaper = 0;
+static int32_t  chargeTaperLimV = 0;
+static int32_t  chargeTaperLimI = 0;
+
+/* SAFE: stepped voltage reference (Q16 0.1V, ceiling chargeSetpoint[CHG_SP_SAFE_V]) */
+static int32_t  chargeSafeV = 0;
+static int32_t  chargeSafeStep = 0;
+static uint32_t chargeSafeTicks = 0;
+static uint16_t chargeSafeShort = 0;
+static uint16_t chargeSafeOpen = 0;
+
+/* Temperature compensation of this tick, 0.1V and raw V_BAT1 counts */
+static int16_t chargeTcDv = 0;
+static int16_t chargeTcRaw = 0;
+
+/* Inputs of the last conversion: batInfo setpoints, the string and the calibration */
+#define CHG_INPUT_COUNT 15
+static uint16_t chargeInput[CHG_INPUT_COUNT];
+
+/* 0.1V -> raw V_BAT1 counts, rounded up so ">=" compares match the display */
+static uint16_t charge_v_raw(uint32_t v_dV)
+{
+	int32_t gain = adcGain[listVBAT1];
+	uint32_t raw;
+
+	if (gain <= 0)
+	{
+		return 0xFFFF;
+	}
+	raw = ((v_dV << 15) + (uint32_t)gain - 1u) / (uint32_t)gain;
+	return (raw > 0xFFFF) ? 0xFFFF : (uint16_t)raw;
+}
+
+/* Background: recompute setpoints and thresholds if batInfo or a gain moved */
+void charge_update_limits(void)
+{
+	uint16_t in[CHG_INPUT_COUNT];
+	uint8_t changed = 0;
+	uint16_t absV, bulkI;
+	uint32_t blocks;
+
+	in[0] = batInfo.absorptionVoltage;
+	in[1] = batInfo.floatVoltage;
+	in[2] = batInfo.storageVoltage;
+	in[3] = batInfo.safeVoltage;
+	in[4] = batInfo.bulkCurrent;
+	in[5] = batInfo.absorptionFinishCurrent;
+	in[6] = (uint16_t)adcGain[listVBAT1];
+	in[7] = (uint16_t)adcGain[listIDC2];
+	in[8] = (uint16_t)adcGain[listIDC2 + 1];
+	in[9] = (uint16_t)adcGain[listIDC2 + 2];
+	in[10] = (uint16_t)adcGain[listIDC2 + 3];
+	in[11] = batInfo.profile;
+	in[12] = batInfo.numberOfBattery;
+	in[13] = batInfo.batteryVoltage;
+	in[14] = batInfo.safeStepMV;
+	for (uint8_t n = 0; n < CHG_INPUT_COUNT; n++)
+	{
+		if (in[n] != chargeInput[n])
+		{
+			chargeInput[n] = in[n];
+			changed = 1;
+		}
+	}
+	if (!changed)
+	{
+		return;
+	}
+
+	absV = (uint16_t)batInfo.absorptionVoltage;
+	bulkI = (uint16_t)(batInfo.bulkCurrent / 10);
+
+	chargeSetpoint[CHG_SP_ABS_V] = absV;
+	chargeSetpoint[CHG_SP_FLOAT_V] = (uint16_t)batInfo.floatVoltage;
+	chargeSetpoint[CHG_SP_STORE_V] = (uint16_t)batInfo.storageVoltage;
+	chargeSetpoint[CHG_SP_EQL_V] = absV + (absV >> CHG_EQL_SHIFT);
+	chargeSetpoint[CHG_SP_SAFE_V] = (uint16_t)batInfo.safeVoltage;
+	chargeSetpoint[CHG_SP_BULK_I] = bulkI;
+	chargeSetpoint[CHG_SP_SAFE_I] = bulkI / CHG_SAFE_I_DIV;
+	chargeSetpoint[CHG_SP_EQL_I] = bulkI / CHG_EQL_I_DIV;
+
+	chargeThRaw[CHG_TH_ABS_V] = charge_v_raw(absV - CHG_V_MARGIN_dV);
+	chargeThRaw[CHG_TH_DEEP_V] = charge_v_raw((uint32_t)absV * CHG_DEEP_PCT / 100u);
+	chargeThRaw[CHG_TH_REBULK_V] = charge_v_raw((uint32_t)batInfo.floatVoltage * CHG_REBULK_PCT / 100u);
+	chargeThRaw[CHG_TH_STORE_V] = charge_v_raw((uint32_t)batInfo.storageVoltage * CHG_REBULK_PCT / 100u);
+	chargeThRaw[CHG_TH_FINISH_I] = (uint16_t)pwl_inverse(&adcIdc2Curve, batInfo.absorptionFinishCurrent);
+
+	/* Slope limits in counts per minute, as numerators: * SLOPE_DEN / samples per minute */
+	chargeTaperLimI = (int32_t)((int64_t)(chargeThRaw[CHG_TH_FINISH_I] - pwl_inverse(&adcIdc2Curve, 0))
+		* SLOPE_DEN / ((60 / CHG_SLOPE_S) * CHG_TAPER_DI_DIV));
+	if (adcGain[listVBAT1] > 0)
+	{
+		chargeTaperLimV = (int32_t)((int64_t)CHG_TAPER_DV_mV * 32768 * SLOPE_DEN
+			/ (100LL * adcGain[listVBAT1] * (60 / CHG_SLOPE_S)));
+	}
+
+	/* SAFE probing: safeStepMV per cell for the whole string */
+	blocks = batInfo.numberOfBattery * ((batInfo.batteryVoltage >= 24u) ? 2u : 1u);
+	chargeSafeStep = (int32_t)((((uint32_t)batInfo.safeStepMV * batteryProfiles[batInfo.profile].cells * blocks) << 16) / 100u);
+	chargeThRaw[CHG_TH_SAFE_LIM_I] = (uint16_t)pwl_inverse(&adcIdc2Curve, chargeSetpoint[CHG_SP_SAFE_I]);
+	chargeThRaw[CHG_TH_SAFE_MIN_I] = (uint16_t)pwl_inverse(&adcIdc2Curve, chargeSetpoint[CHG_SP_SAFE_I] / CHG_SAFE_MIN_DIV);
+	chargeThRaw[CHG_TH_SAFE_TRIP_I] = (uint16_t)pwl_inverse(&adcIdc2Curve, chargeSetpoint[CHG_SP_SAFE_I] * CHG_SAFE_TRIP_MUL);
+	chargeThRaw[CHG_TH_SAFE_SHORT_V] = charge_v_raw(CHG_SAFE_SHORT_dV * blocks);
+	chargeThRaw[CHG_TH_SAFE_MAX_V] = charge_v_raw(batInfo.safeVoltage + CHG_SAFE_MAX_dV);
+
+	tc_build();
+}
+
+static void charge_enter(uint8_t next)
+{
+	if (next == CHG_NEXT_OFF)
+	{
+		HAL_GPIO_WritePin(SHUTDOWN2_GPIO_Port, SHUTDOWN2_Pin, GPIO_PIN_RESET);
+		deviceOn = 0;
+		return;
+	}
+	if (next == STATE_EQUALIZATION && !batInfo.equalizationEnabled)
+	{
+		next = STATE_FLOAT;
+	}
+	if (next == STATE_BATTERY_SAFE)
+	{
+		/* Probe from where the battery is */
+		chargeSafeV = (int32_t)adcVBAT1 << 16;
+		chargeSafeTicks = 0;
+		chargeSafeShort = 0;
+		chargeSafeOpen = 0;
+	}
+	batInfo.chargeState = (ChargeState_t)next;
+	chargeStageMinutes = 0;
+	chargeHold = 0;
+	chargeSlopeTicks = 0;
+	chargeTaper = 0;
+	slope_reset(&chargeSlopeV);
+	slope_reset(&chargeSlopeI);
+}
+
+/* Background (ON button): new charge, SAFE first for a deeply discharged battery */
+void charge_start(void)
+{
+	charge_update_limits();
+	chargeTicks = 0;
+	batInfo.chargeMinute = 0;
+	batInfo.chargeHour = 0;
+	batInfo.chargeDay = 0;
+	batInfo.chargeWeek = 0;
+	if (batInfo.safeChargeEnabled && adc_filter_out(listVBAT1) < chargeThRaw[CHG_TH_DEEP_V])
+	{
+		charge_enter(STATE_BATTERY_SAFE);
+	}
+	else
+	{
+		charge_enter(STATE_BULK);
+	}
+}
+
+static void charge_minute(void)
+{
+	if (chargeStageMinutes < 0xFFFF)
+	{
+		chargeStageMinutes++;
+	}
+	if (++batInfo.chargeMinute < 60)
+	{
+		return;
+	}
+	batInfo.chargeMinute = 0;
+	if (++batInfo.chargeHour < 24)
+	{
+		return;
+	}
+	batInfo.chargeHour = 0;
+	if (++batInfo.chargeDay < 7)
+	{
+		return;
+	}
+	batInfo.chargeDay = 0;
+	if (batInfo.chargeWeek < 255)
+	{
+		batInfo.chargeWeek++;
+	}
+}
+
+/* Closed window: count windows in a row with a low, settled current and a
+ * settled voltage */
+static void charge_taper(void)
+{
+	int32_t dv = chargeSlopeV.num;
+	int32_t di = chargeSlopeI.num;
+
+	if (dv < 0)
+	{
+		dv = -dv;
+	}
+	if (di < 0)
+	{
+		di = -di;
+	}
+	if (chargeSlopeI.mean < chargeThRaw[CHG_TH_FINISH_I] && di <= chargeTaperLimI && dv <= chargeTaperLimV)
+	{
+		if (chargeTaper < 0xFF)
+		{
+			chargeTaper++;
+		}
+	}
+	else
+	{
+		chargeTaper = 0;
+	}
+}
+
+/* SAFE, every tick: anomalies end the charge at once, the probe voltage
+ * steps while the battery takes less than the SAFE current.
+ * Returns 1 when the output was switched off. */
+static uint8_t charge_safe(void)
+{
+	uint16_t i = adcIDC2NoGain;
+	uint16_t v = adc_filter_out(listVBAT1);
+	int32_t ceiling = (int32_t)chargeSetpoint[CHG_SP_SAFE_V] << 16;
+
+	if (i >= chargeThRaw[CHG_TH_SAFE_TRIP_I])
+	{
+		protect_trip((v < chargeThRaw[CHG_TH_SAFE_SHORT_V]) ? FAULT_BAT_SHORT : FAULT_OVERCURRENT);
+		return 1;
+	}
+	if (v >= chargeThRaw[CHG_TH_SAFE_MAX_V])
+	{
+		/* Output ran away from the probe: nothing on the terminals */
+		protect_trip(FAULT_BAT_OPEN);
+		return 1;
+	}
+
+	/* Limit current with the battery still near zero volts */
+	if (i >= chargeThRaw[CHG_TH_SAFE_LIM_I] && v < chargeThRaw[CHG_TH_SAFE_SHORT_V])
+	{
+		if (++chargeSafeShort >= CHG_SAFE_SHORT_TICKS)
+		{
+			protect_trip(FAULT_BAT_SHORT);
+			return 1;
+		}
+	}
+	else
+	{
+		chargeSafeShort = 0;
+	}
+
+	/* Probe at its ceiling and the battery still takes nothing */
+	if (chargeSafeV >= ceiling && i < chargeThRaw[CHG_TH_SAFE_MIN_I])
+	{
+		if (++chargeSafeOpen >= CHG_SAFE_OPEN_TICKS)
+		{
+			protect_trip(FAULT_BAT_OPEN);
+			return 1;
+		}
+	}
+	else
+	{
+		chargeSafeOpen = 0;
+	}
+
+	if (++chargeSafeTicks >= CHG_SAFE_STEP_TICKS)
+	{
+		chargeSafeTicks = 0;
+		if (i < chargeThRaw[CHG_TH_SAFE_LIM_I])
+		{
+			chargeSafeV += chargeSafeStep;
+			if (chargeSafeV > ceiling)
+			{
+				chargeSafeV = ceiling;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Control tick, charger mode: stage timers and exit compares on raw counts */
+void charge_tick(void)
+{
+	const CHARGE_STAGE *st = &chargeTable[batInfo.chargeState];
+	int32_t th = chargeThRaw[st->exitTh];
+	uint8_t hit = 0;
+	uint8_t tc = tc_index(thermalAmbient_C);
+
+	chargeTcDv = tcLut_dV[tc];
+	chargeTcRaw = tcLutRaw[tc];
+	/* Thresholds tied to a compensated setpoint move with it */
+	if (st->exitTh == CHG_TH_ABS_V || st->exitTh == CHG_TH_REBULK_V || st->exitTh == CHG_TH_STORE_V)
+	{
+		th += chargeTcRaw;
+	}
+
+	if (++chargeTicks >= CHG_TICKS_PER_MIN)
+	{
+		chargeTicks = 0;
+		charge_minute();
+	}
+	if (++chargeSlopeTicks >= CHG_SLOPE_TICKS)
+	{
+		chargeSlopeTicks = 0;
+		slope_add(&chargeSlopeV, adc_filter_out(listVBAT1));
+		if (slope_add(&chargeSlopeI, adcIDC2NoGain))
+		{
+			charge_taper();
+		}
+	}
+
+	if (batInfo.chargeState == STATE_BATTERY_SAFE && charge_safe())
+	{
+		return;
+	}
+
+	switch (st->exitCond)
+	{
+	case CHG_EXIT_V_ABOVE:
+		hit = (adc_filter_out(listVBAT1) >= th);
+		break;
+	case CHG_EXIT_V_BELOW:
+		hit = (adc_filter_out(listVBAT1) < th);
+		break;
+	case CHG_EXIT_I_BELOW:
+		hit = (adcIDC2NoGain < th);
+		break;
+	case CHG_EXIT_TAPER:
+		hit = (chargeTaper >= CHG_TAPER_WINDOWS);
+		break;
+	case CHG_EXIT_SAFE:
+		hit = (adc_filter_out(listVBAT1) >= th && adcIDC2NoGain >= chargeThRaw[CHG_TH_SAFE_MIN_I]);
+		break;
+	default:
+		break;
+	}
+
+	if (!hit)
+	{
+		chargeHold = 0;
+	}
+	else if (++chargeHold >= CHG_HOLD_TICKS)
+	{
+		charge_enter(st->exitNext);
+		return;
+	}
+	if (st->timeout_min != 0 && chargeStageMinutes >= st->timeout_min)
+	{
+		charge_enter(st->timeoutNext);
+	}
+}
+
+uint8_t charge_stage_loop(void)
+{
+	return chargeTable[batInfo.chargeState].loop;
+}
+
+/* Stage voltage with temperature compensation, SAFE probes uncompensated */
+uint16_t charge_vset(void)
+{
+	uint8_t sp = chargeTable[batInfo.chargeState].vSp;
+	int32_t v = chargeSetpoint[sp];
+
+	if (sp == CHG_SP_SAFE_V)
+	{
+		v = chargeSafeV >> 16;
+	}
+	else
+	{
+		v += chargeTcDv;
+	}
+	if (v < 0)
+	{
+		v = 0;
+	}
+	else if (v > vMax_dV)
+	{
+		v = vMax_dV;
+	}
+	return (uint16_t)v;
+}
+
+uint16_t charge_iset(void)
+{
+	return chargeSetpoint[chargeTable[batInfo.chargeState].iSp];
+}
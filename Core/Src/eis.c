@@ -0,0 +1,226 @@
+/*
+ * eis.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "eis.h"
+#include "adc.h"
+#include "adc_filter.h"
+#include "out_control.h"
+#include "autotune.h"
+#include "irtest.h"
+#include "charge.h"
+#include "pwl.h"
+
+#if ADC_SAMPLE_RATE_HZ != 1000
+#error "eisCos/eisSin are computed for ADC_SAMPLE_RATE_HZ 1000"
+#endif
+
+#define EIS_SLOPE_MAX   (1L << 24)      /* Q16 V/I counts */
+#define EIS_CURVE_DX    64              /* I_DC2 curve slope over +-64 counts */
+
+/* 2^32 phase per cycle, stepped once per control tick */
+#define EIS_PHASE_INC(f)    ((uint32_t)(((uint64_t)(f) << 32) / OUT_CONTROL_RATE_HZ))
+
+extern DAC_HandleTypeDef hdac;
+
+const uint16_t eisFreq_Hz[EIS_POINTS] = { 1, 2, 5, 10, 20, 50, 100, 200 };
+
+static const uint32_t eisPhaseInc[EIS_POINTS] = {
+	EIS_PHASE_INC(1), EIS_PHASE_INC(2), EIS_PHASE_INC(5), EIS_PHASE_INC(10),
+	EIS_PHASE_INC(20), EIS_PHASE_INC(50), EIS_PHASE_INC(100), EIS_PHASE_INC(200),
+};
+
+/* cos / sin(2 pi f / 1000 Hz), Q30. cos Q30 is 2cos Q29, the Goertzel coefficient. */
+static const int32_t eisCos[EIS_POINTS] = {
+	1073720629, 1073657046, 1073211997, 1071623040,
+	1065275049, 1021189159,  868675383,  331804471,
+};
+static const int32_t eisSin[EIS_POINTS] = {
+	   6746474,   13492683,   33727046,   67420807,
+	 134575535,  331804471,  631129609, 1021189159,
+};
+
+/* One cycle, Q15 */
+static const q15_t eisSine[64] = {
+	     0,   3212,   6393,   9512,  12539,  15446,  18204,  20787,
+	 23170,  25329,  27245,  28898,  30273,  31356,  32137,  32609,
+	 32767,  32609,  32137,  31356,  30273,  28898,  27245,  25329,
+	 23170,  20787,  18204,  15446,  12539,   9512,   6393,   3212,
+	     0,  -3212,  -6393,  -9512, -12539, -15446, -18204, -20787,
+	-23170, -25329, -27245, -28898, -30273, -31356, -32137, -32609,
+	-32767, -32609, -32137, -31356, -30273, -28898, -27245, -25329,
+	-23170, -20787, -18204, -15446, -12539,  -9512,  -6393,  -3212,
+};
+
+EIS eis = { .state = EIS_IDLE };
+EIS_RESULT eisTable[EIS_POINTS];
+
+/* Background (Right on PAGE_OUTPUT_CONTROL): charger must be running with
+ * enough current that the sine does not reach zero */
+void eis_start(void)
+{
+	EIS *e = &eis;
+
+	if (eis_active())
+	{
+		return;
+	}
+	if (!deviceOn || operatingMode != MODE_CHARGER || autotune_active() || irtest_active()
+		|| adcIDC2 < EIS_MIN_I_dA
+		|| dacValueV < PID_DAC_MIN + EIS_AMP_DAC || dacValueV > PID_DAC_MAX - EIS_AMP_DAC)
+	{
+		e->state = EIS_FAILED;
+		return;
+	}
+	for (uint8_t p = 0; p < EIS_POINTS; p++)
+	{
+		eisTable[p].re_uOhm = 0;
+		eisTable[p].im_uOhm = 0;
+	}
+	e->dacHold = dacValueV;
+	e->phase = 0;
+	e->point = 0;
+	e->ticks = 0;
+	e->state = EIS_SETTLE;
+}
+
+void eis_abort(void)
+{
+	if (eis_active())
+	{
+		eis.state = EIS_FAILED;
+	}
+}
+
+uint8_t eis_active(void)
+{
+	return (eis.state >= EIS_SETTLE && eis.state <= EIS_POINT);
+}
+
+/* ADC block handler, per sequence: Goertzel resonators on the AC part */
+void eis_sample(uint16_t iRaw, uint16_t vRaw)
+{
+	EIS *e = &eis;
+	int64_t c;
+	int32_t s;
+
+	if (e->state != EIS_DETECT)
+	{
+		return;
+	}
+	c = eisCos[e->point];
+
+	s = ((int32_t)vRaw - e->vRef) + (int32_t)((c * e->v1) >> 29) - e->v2;
+	e->v2 = e->v1;
+	e->v1 = s;
+
+	s = ((int32_t)iRaw - e->iRef) + (int32_t)((c * e->i1) >> 29) - e->i2;
+	e->i2 = e->i1;
+	e->i1 = s;
+
+	if (++e->n >= EIS_N)
+	{
+		e->state = EIS_POINT;
+	}
+}
+
+/* Control tick, owns the DAC while the sweep is active */
+void eis_tick(void)
+{
+	EIS *e = &eis;
+
+	if (adcVBAT1 > charge_vset() + EIS_V_MARGIN_dV || adcVBAT1 > vMax_dV)
+	{
+		e->state = EIS_FAILED;
+		return;
+	}
+
+	e->phase += eisPhaseInc[e->point];
+	dacValueV = (int16_t)(e->dacHold + (((int32_t)EIS_AMP_DAC * eisSine[e->phase >> 26]) >> 15));
+	HAL_DAC_SetValue(&hdac, DAC_CHANNEL_2, DAC_ALIGN_12B_R, dacValueV);
+
+	e->ticks++;
+	if (e->state == EIS_SETTLE && e->ticks >= EIS_SETTLE_TICKS)
+	{
+		/* Resonators are cleared before the block handler sees DETECT */
+		e->v1 = e->v2 = 0;
+		e->i1 = e->i2 = 0;
+		e->n = 0;
+		e->vRef = adc_filter_out(listVBAT1);
+		e->iRef = adc_filter_out(listIDC2);
+		e->ticks = 0;
+		e->state = EIS_DETECT;
+	}
+	else if (e->state == EIS_DETECT && e->ticks > EIS_DETECT_TICKS)
+	{
+		e->state = EIS_FAILED;
+	}
+}
+
+/* Bin output y = s1 - s2 e^-jw, raw counts */
+static void eis_phasor(int32_t s1, int32_t s2, uint8_t p, int64_t *re, int64_t *im)
+{
+	*re = s1 - (((int64_t)s2 * eisCos[p]) >> 30);
+	*im = ((int64_t)s2 * eisSin[p]) >> 30;
+}
+
+/* Raw slope (Q16 V counts per I count) to micro-ohms, see irtest_update() */
+static int32_t eis_uohm(int64_t q, int32_t gain, int32_t dRaw, int32_t d_dA)
+{
+	int64_t t;
+
+	if (q > EIS_SLOPE_MAX)
+	{
+		q = EIS_SLOPE_MAX;
+	}
+	else if (q < -EIS_SLOPE_MAX)
+	{
+		q = -EIS_SLOPE_MAX;
+	}
+	t = ((q * gain) >> 15) * dRaw / d_dA;
+	return (int32_t)((t * 15625) >> 10);
+}
+
+/* Background: Z = V / I = V conj(I) / |I|^2 for the finished bin, next point */
+void eis_update(void)
+{
+	EIS *e = &eis;
+	uint8_t p = e->point;
+	int64_t vr, vi, ir, ii, den, amp;
+	int32_t gain = adcGain[listVBAT1];
+	int32_t lo, d_dA;
+
+	if (e->state != EIS_POINT)
+	{
+		return;
+	}
+
+	eis_phasor(e->v1, e->v2, p, &vr, &vi);
+	eis_phasor(e->i1, e->i2, p, &ir, &ii);
+	den = ir * ir + ii * ii;
+	amp = (int64_t)EIS_N * EIS_MIN_AMP_RAW / 2;     /* bin magnitude of that amplitude */
+
+	/* I_DC2 curve slope at the operating point */
+	lo = (e->iRef > EIS_CURVE_DX) ? (int32_t)e->iRef - EIS_CURVE_DX : 0;
+	d_dA = pwl_interp(&adcIdc2Curve, lo + 2 * EIS_CURVE_DX) - pwl_interp(&adcIdc2Curve, lo);
+
+	if (den < amp * amp || d_dA <= 0 || gain <= 0)
+	{
+		e->state = EIS_FAILED;
+		return;
+	}
+	eisTable[p].re_uOhm = eis_uohm(((vr * ir + vi * ii) << 16) / den, gain, 2 * EIS_CURVE_DX, d_dA);
+	eisTable[p].im_uOhm = eis_uohm(((vi * ir - vr * ii) << 16) / den, gain, 2 * EIS_CURVE_DX, d_dA);
+
+	if (p + 1u >= EIS_POINTS)
+	{
+		e->state = EIS_DONE;
+		return;
+	}
+	e->point = (uint8_t)(p + 1u);
+	e->ticks = 0;
+	e->state = EIS_SETTLE;
+}
@@ -0,0 +1,128 @@
+/*
+ * feedforward.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "feedforward.h"
+#include "fixmath.h"
+
+FF_MODEL ffModel = { 0, 0, 0 };
+
+/* Background -> tick handover of a new fit. ffNext is plain data, the
+ * barriers order it against the volatile flag on both sides. */
+static FF_MODEL ffNext;
+static volatile uint8_t ffPending = 0;
+
+/* Tick side block accumulator */
+static int32_t ffSumV = 0;
+static int32_t ffSumDac = 0;
+static uint16_t ffCount = 0;
+static int16_t ffLastDac = 0;
+static int32_t ffBlockV = 0;
+static int32_t ffBlockDac = 0;
+static volatile uint8_t ffBlockReady = 0;
+
+/* Background side: exponentially forgotten LS sums over Q8 block means.
+ * n is Q8 too and settles at 2^FF_FORGET_SHIFT. */
+static int64_t ffN = 0;
+static int64_t ffSx = 0;
+static int64_t ffSy = 0;
+static int64_t ffSxx = 0;
+static int64_t ffSxy = 0;
+
+int16_t ff_dac(int32_t v_dV)
+{
+	if (!ffModel.valid)
+	{
+		return 0;
+	}
+	return fx_sat16(fx_mul_shift(ffModel.gain, v_dV, 12) + ffModel.offset);
+}
+
+/* Control tick: output switched on, or the DAC moved, drop the partial block */
+void ff_restart(void)
+{
+	ffSumV = 0;
+	ffSumDac = 0;
+	ffCount = 0;
+}
+
+/* Control tick: steady samples only */
+void ff_sample(int32_t v_dV, int16_t dac)
+{
+	int16_t step = dac - ffLastDac;
+
+	ffLastDac = dac;
+	if (ffBlockReady)
+	{
+		return;
+	}
+	if (step > FF_STEADY_DAC || step < -FF_STEADY_DAC)
+	{
+		ff_restart();
+		return;
+	}
+	ffSumV += v_dV;
+	ffSumDac += dac;
+	if (++ffCount == (1u << FF_BLOCK_SHIFT))
+	{
+		ffBlockV = ffSumV;
+		ffBlockDac = ffSumDac;
+		ffBlockReady = 1;
+		ff_restart();
+	}
+}
+
+/* Control tick: take over a new fit, returns 1 if the model changed */
+uint8_t ff_install(void)
+{
+	if (!ffPending)
+	{
+		return 0;
+	}
+	__DMB();
+	ffModel = ffNext;
+	ffPending = 0;
+	return 1;
+}
+
+/* Background: fold a finished block into the fit */
+void ff_update(void)
+{
+	int64_t x, y, det, num, spread;
+
+	if (!ffBlockReady || ffPending)
+	{
+		return;
+	}
+	x = ffBlockV >> (FF_BLOCK_SHIFT - 8);
+	y = ffBlockDac >> (FF_BLOCK_SHIFT - 8);
+	ffBlockReady = 0;
+
+	ffN   += 256 - (ffN >> FF_FORGET_SHIFT);
+	ffSx  += x - (ffSx >> FF_FORGET_SHIFT);
+	ffSy  += y - (ffSy >> FF_FORGET_SHIFT);
+	ffSxx += x * x - (ffSxx >> FF_FORGET_SHIFT);
+	ffSxy += x * y - (ffSxy >> FF_FORGET_SHIFT);
+
+	det = ((ffN * ffSxx) >> 8) - ffSx * ffSx;
+	num = ((ffN * ffSxy) >> 8) - ffSx * ffSy;
+	spread = (int64_t)FF_MIN_SPREAD_dV * FF_MIN_SPREAD_dV * ffN * ffN;
+
+	ffNext = ffModel;
+	if (det > spread)
+	{
+		ffNext.gain = (int32_t)((num << 12) / det);
+		ffNext.valid = 1;
+	}
+	if (!ffNext.valid)
+	{
+		return;
+	}
+	/* Gain kept while VBAT sits still, the offset follows drift */
+	ffNext.offset = (int32_t)((ffSy - ((ffSx * ffNext.gain) >> 12)) / ffN);
+	__DMB();
+	ffPending = 1;
+}
@@ -0,0 +1,78 @@
+/*
+ * fixmath.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "fixmath.h"
+
+/* floor(sqrt(x)), bit-by-bit, at most 16 iterations */
+uint32_t fx_isqrt32(uint32_t x)
+{
+	uint32_t res = 0;
+	uint32_t bit;
+
+	if (x == 0)
+	{
+		return 0;
+	}
+
+	/* Highest power of four <= x */
+	bit = 1UL << ((31u - __CLZ(x)) & ~1u);
+
+	while (bit != 0)
+	{
+		if (x >= res + bit)
+		{
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else
+		{
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return res;
+}
+
+/* floor(sqrt(x)) for 64-bit sums of squares */
+uint32_t fx_isqrt64(uint64_t x)
+{
+	uint64_t res = 0;
+	uint64_t bit;
+	uint32_t hi = (uint32_t)(x >> 32);
+
+	if (hi == 0)
+	{
+		return fx_isqrt32((uint32_t)x);
+	}
+
+	bit = 1ULL << ((63u - __CLZ(hi)) & ~1u);
+
+	while (bit != 0)
+	{
+		if (x >= res + bit)
+		{
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else
+		{
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)res;
+}
+
+/* ceil(2^32 / d) for fx_div_recip(), d >= 2 */
+uint32_t fx_recip(uint32_t d)
+{
+	if (d < 2)
+	{
+		return UINT32_MAX;
+	}
+	return (uint32_t)((0xFFFFFFFFUL / d) + 1u);
+}
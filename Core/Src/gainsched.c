@@ -0,0 +1,96 @@
+/*
+ * gainsched.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "gainsched.h"
+#include "out_control.h"
+#include "fixmath.h"
+
+/* Rows: current 0, 12.8, 25.6, 38.4, 51.2A.
+ * Cols: voltage 0, 6.4, 12.8, 19.2, 25.6, 32.0, 38.4, 44.8, 51.2V.
+ * Base gains were tuned on a single 12V block at low current, that corner is 1.0. */
+
+/* Voltage loop: converter droop adds loop gain at high current */
+static const uint16_t gsVoutTable[GS_I_POINTS][GS_V_POINTS] = {
+	{ 4096, 4096, 4096, 4096, 4096, 4096, 4096, 4096, 4096 },
+	{ 4096, 4096, 4096, 4096, 4096, 4096, 4096, 4096, 4096 },
+	{ 4506, 4506, 4506, 4506, 4506, 4506, 4506, 4506, 4506 },
+	{ 4915, 4915, 4915, 4915, 4915, 4915, 4915, 4915, 4915 },
+	{ 4915, 4915, 4915, 4915, 4915, 4915, 4915, 4915, 4915 },
+};
+
+/* Current loop: plant gain falls with the string resistance (block count),
+ * scale follows V / 12.8V, limited to 3x */
+static const uint16_t gsIoutTable[GS_I_POINTS][GS_V_POINTS] = {
+	{ 4096, 4096, 4096, 6144, 8192, 10240, 12288, 12288, 12288 },
+	{ 4096, 4096, 4096, 6144, 8192, 10240, 12288, 12288, 12288 },
+	{ 4096, 4096, 4096, 6144, 8192, 10240, 12288, 12288, 12288 },
+	{ 4096, 4096, 4096, 6144, 8192, 10240, 12288, 12288, 12288 },
+	{ 4096, 4096, 4096, 6144, 8192, 10240, 12288, 12288, 12288 },
+};
+
+PID_GAINS pidVoutBase = { PID_VOUT_KP, PID_VOUT_KI, PID_VOUT_KD };
+PID_GAINS pidIoutBase = { PID_IOUT_KP, PID_IOUT_KI, PID_IOUT_KD };
+uint16_t gsScaleV = 4096;
+uint16_t gsScaleI = 4096;
+
+/* Bilinear Q12 scale at (v, i): cell index by shift, weights by mask */
+uint16_t gs_lookup(const uint16_t (*table)[GS_V_POINTS], int32_t v_dV, int32_t i_dA)
+{
+	int32_t vi, vf, ii, iF, a, b;
+
+	if (v_dV < 0)
+	{
+		v_dV = 0;
+	}
+	else if (v_dV > GS_V_MAX)
+	{
+		v_dV = GS_V_MAX;
+	}
+	if (i_dA < 0)
+	{
+		i_dA = 0;
+	}
+	else if (i_dA > GS_I_MAX)
+	{
+		i_dA = GS_I_MAX;
+	}
+
+	vi = v_dV >> GS_V_SHIFT;
+	vf = v_dV & ((1 << GS_V_SHIFT) - 1);
+	ii = i_dA >> GS_I_SHIFT;
+	iF = i_dA & ((1 << GS_I_SHIFT) - 1);
+
+	a = table[ii][vi] + (((table[ii][vi + 1] - table[ii][vi]) * vf) >> GS_V_SHIFT);
+	b = table[ii + 1][vi] + (((table[ii + 1][vi + 1] - table[ii + 1][vi]) * vf) >> GS_V_SHIFT);
+	return (uint16_t)(a + (((b - a) * iF) >> GS_I_SHIFT));
+}
+
+/* Control tick: scale the base gains for the present operating point */
+void gs_apply(int32_t v_dV, int32_t i_dA)
+{
+	gsScaleV = gs_lookup(gsVoutTable, v_dV, i_dA);
+	gsScaleI = gs_lookup(gsIoutTable, v_dV, i_dA);
+
+	pidVout.kp = fx_mul_shift(pidVoutBase.kp, gsScaleV, 12);
+	pidVout.ki = fx_mul_shift(pidVoutBase.ki, gsScaleV, 12);
+	pidVout.kd = fx_mul_shift(pidVoutBase.kd, gsScaleV, 12);
+	pidIout.kp = fx_mul_shift(pidIoutBase.kp, gsScaleI, 12);
+	pidIout.ki = fx_mul_shift(pidIoutBase.ki, gsScaleI, 12);
+	pidIout.kd = fx_mul_shift(pidIoutBase.kd, gsScaleI, 12);
+}
+
+/* Background: gains measured at 'scale' back to base (unscaled) gains */
+void gs_set_base(PID_GAINS *base, int32_t kp, int32_t ki, uint16_t scale)
+{
+	if (scale == 0)
+	{
+		return;
+	}
+	base->kp = (int32_t)(((int64_t)kp << 12) / scale);
+	base->ki = (int32_t)(((int64_t)ki << 12) / scale);
+	base->kd = 0;
+}
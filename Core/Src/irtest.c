@@ -0,0 +1,211 @@
+/*
+ * irtest.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "irtest.h"
+#include "adc.h"
+#include "out_control.h"
+#include "autotune.h"
+#include "charge.h"
+#include "eis.h"
+#include "pwl.h"
+
+#define IR_SLOPE_MAX    (1L << 24)      /* Q16 V/I counts, no battery on the output */
+
+extern DAC_HandleTypeDef hdac;
+
+IR_TEST irTest = { .state = IRT_IDLE };
+
+/* Background (Right on PAGE_OUTPUT_CONTROL): charger must be running */
+void irtest_start(void)
+{
+	IR_TEST *ir = &irTest;
+	uint16_t i = testCurrent_dA;
+
+	if (irtest_active())
+	{
+		return;
+	}
+	if (!deviceOn || operatingMode != MODE_CHARGER || autotune_active() || eis_active())
+	{
+		ir->state = IRT_FAILED;
+		return;
+	}
+	if (i > iMax_dA)
+	{
+		i = iMax_dA;
+	}
+	ir->iHigh_dA = i;
+	ir->iLow_dA = i / IR_LOW_DIV;
+	ir->ticks = 0;
+	ir->count = 0;
+	ir->stepIdx = 0;
+	ir->step_dA = 0;
+	ir->r_uOhm = 0;
+	ir->state = IRT_SETTLE_HI;
+}
+
+void irtest_abort(void)
+{
+	if (irtest_active())
+	{
+		irTest.state = IRT_FAILED;
+	}
+}
+
+uint8_t irtest_active(void)
+{
+	return (irTest.state >= IRT_SETTLE_HI && irTest.state <= IRT_MEASURED);
+}
+
+/* ADC block handler, per sequence: burst capture and the DAC step after the
+ * newest sequence of a block, so the next conversion is the first one past it */
+void irtest_sample(uint16_t iRaw, uint16_t vRaw, uint8_t remain)
+{
+	IR_TEST *ir = &irTest;
+	uint8_t n;
+
+	if (ir->state != IRT_CAPTURE)
+	{
+		return;
+	}
+	n = ir->count;
+	ir->iRaw[n] = iRaw;
+	ir->vRaw[n] = vRaw;
+	ir->count = ++n;
+	if (n >= IR_BURST)
+	{
+		ir->state = IRT_MEASURED;
+		return;
+	}
+	if (ir->stepIdx == 0 && n >= IR_PRE && remain == 0)
+	{
+		ir->stepIdx = n;
+		dacValueV = ir->dacHigh;
+		HAL_DAC_SetValue(&hdac, DAC_CHANNEL_2, DAC_ALIGN_12B_R, dacValueV);
+	}
+}
+
+/* Control tick, owns the DAC while the test is active */
+void irtest_tick(void)
+{
+	IR_TEST *ir = &irTest;
+	int32_t ref;
+
+	if (adcVBAT1 > charge_vset() + IR_V_MARGIN_dV || adcVBAT1 > vMax_dV)
+	{
+		ir->state = IRT_FAILED;
+		return;
+	}
+
+	switch (ir->state)
+	{
+	case IRT_SETTLE_HI:
+	case IRT_SETTLE_LO:
+		ref = (ir->state == IRT_SETTLE_HI) ? ir->iHigh_dA : ir->iLow_dA;
+		if (ir->ticks == 0)
+		{
+			pid_prime(&pidIout, ref, adcIDC2, dacValueV);
+		}
+		dacValueV = pid_update(&pidIout, ref, adcIDC2);
+		HAL_DAC_SetValue(&hdac, DAC_CHANNEL_2, DAC_ALIGN_12B_R, dacValueV);
+		if (++ir->ticks < IR_SETTLE_TICKS)
+		{
+			break;
+		}
+		if (adcIDC2 > ref + IR_SETTLE_TOL_dA || adcIDC2 + IR_SETTLE_TOL_dA < ref)
+		{
+			ir->state = IRT_FAILED;
+			break;
+		}
+		ir->ticks = 0;
+		if (ir->state == IRT_SETTLE_HI)
+		{
+			ir->dacHigh = dacValueV;
+			ir->state = IRT_SETTLE_LO;
+		}
+		else if (ir->dacHigh > dacValueV)
+		{
+			/* DAC stays at the low code until the block handler steps it */
+			ir->dacLow = dacValueV;
+			ir->state = IRT_CAPTURE;
+		}
+		else
+		{
+			ir->state = IRT_FAILED;
+		}
+		break;
+	case IRT_CAPTURE:
+		if (++ir->ticks > IR_CAPTURE_TICKS)
+		{
+			ir->state = IRT_FAILED;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* Background: least-squares slope of V over I in raw counts, scaled by the
+ * V_BAT1 gain and the I_DC2 curve slope across the step.
+ * R = slope * gain / 32768 (0.1V per I count) * dRaw / step_dA (I counts per 0.1A) */
+void irtest_update(void)
+{
+	IR_TEST *ir = &irTest;
+	int64_t sx = 0, sy = 0, sxx = 0, sxy = 0;
+	int64_t q, t;
+	uint32_t lo = 0, hi = 0;
+	int32_t loRaw, hiRaw, step;
+	int32_t gain = adcGain[listVBAT1];
+
+	if (ir->state != IRT_MEASURED)
+	{
+		return;
+	}
+
+	for (uint8_t n = 0; n < IR_BURST; n++)
+	{
+		int32_t x = ir->iRaw[n];
+		int32_t y = ir->vRaw[n];
+
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+		if (n < ir->stepIdx)
+		{
+			lo += (uint32_t)x;
+		}
+		else if (n >= IR_BURST - IR_HI_AVG)
+		{
+			hi += (uint32_t)x;
+		}
+	}
+	sxx = IR_BURST * sxx - sx * sx;
+	sxy = IR_BURST * sxy - sx * sy;
+
+	loRaw = (ir->stepIdx != 0) ? (int32_t)(lo / ir->stepIdx) : 0;
+	hiRaw = (int32_t)(hi / IR_HI_AVG);
+	step = pwl_interp(&adcIdc2Curve, hiRaw) - pwl_interp(&adcIdc2Curve, loRaw);
+
+	if (ir->stepIdx == 0 || step < IR_MIN_STEP_dA || sxx <= 0 || sxy < 0 || gain <= 0)
+	{
+		ir->state = IRT_FAILED;
+		return;
+	}
+	q = (sxy << 16) / sxx;
+	if (q > IR_SLOPE_MAX)
+	{
+		ir->state = IRT_FAILED;
+		return;
+	}
+
+	/* Q16 ohms, then 1e6 / 65536 = 15625 / 1024 */
+	t = ((q * gain) >> 15) * (hiRaw - loRaw) / step;
+	ir->step_dA = (uint16_t)step;
+	ir->r_uOhm = (uint32_t)((t * 15625) >> 10);
+	ir->state = IRT_DONE;
+}
@@ -12,6 +12,13 @@
 #include "adc.h"
 #include "main.h"
 #include "out_control.h"
+#include "protect.h"
+#include "autotune.h"
+#include "charge.h"
+#include "profile.h"
+#include "soc.h"
+#include "irtest.h"
+#include "eis.h"
 
 /** @name Global State Variables */
 /**@{*/
@@ -103,6 +110,34 @@ static const char * const STAGE_TR_SHORT[] = {
 static const char * const * STAGE_NAMES_LANG[2] = { STAGE_EN_SHORT, STAGE_TR_SHORT };
 /**@}*/
 
+/** @name Battery profile names (indexed by BatteryProfile_t) */
+/**@{*/
+static const char * const PROFILE_EN[PROF_COUNT] = { "Flooded", "AGM    ", "Gel    ", "Calcium", "LiFePO4" };
+static const char * const PROFILE_TR[PROF_COUNT] = { "Sulu    ", "AGM     ", "Jel     ", "Kalsiyum", "LiFePO4 " };
+static const char * const * PROFILE_NAMES_LANG[2] = { PROFILE_EN, PROFILE_TR };
+/**@}*/
+
+/** @name Latched fault messages for PAGE_MAIN row 3 (indexed by FaultCode_t) */
+/**@{*/
+static const char * const FAULT_EN[FAULT_COUNT] = {
+	/* FAULT_NONE */		  "                    ",
+	/* FAULT_OVERCURRENT */	  "FAULT: OVERCURRENT  ",
+	/* FAULT_SHORT */		  "FAULT: SHORT CIRCUIT",
+	/* FAULT_BAT_SHORT */	  "FAULT: BATTERY SHORT",
+	/* FAULT_BAT_OPEN */	  "FAULT: BATTERY OPEN "
+};
+
+static const char * const FAULT_TR[FAULT_COUNT] = {
+	/* FAULT_NONE */		  "                    ",
+	/* FAULT_OVERCURRENT */	  "HATA: ASIRI AKIM    ",
+	/* FAULT_SHORT */		  "HATA: KISA DEVRE    ",
+	/* FAULT_BAT_SHORT */	  "HATA: AKU KISA DEVRE",
+	/* FAULT_BAT_OPEN */	  "HATA: AKU ACIK DEVRE"
+};
+
+static const char * const * FAULT_NAMES_LANG[2] = { FAULT_EN, FAULT_TR };
+/**@}*/
+
 /* String table keys for i18n */
 typedef enum {
     UI_STR_MENU_TITLE = 0,
@@ -122,6 +157,7 @@ typedef enum {
     UI_LBL_BATV,
     UI_LBL_CAPACITY,
     UI_LBL_COUNT,
+    UI_LBL_PROFILE,
     UI_STR_OPEN,
     UI_STR_CLOSE,
     UI_STR_CHARGER_NAME,
@@ -135,7 +171,8 @@ typedef enum {
     UI_STR_MFG_GAIN,
     UI_STR_MFG_OFFSET,
     UI_STR_MFG_LIMITS,
-    UI_STR_MFG_MODE
+    UI_STR_MFG_MODE,
+    UI_STR_MFG_TUNE
 } UiStrId;
 
 static const char * const UI_STR_EN[] = {
@@ -156,6 +193,7 @@ static const char * const UI_STR_EN[] = {
     [UI_LBL_BATV]          = "Bat V:",
     [UI_LBL_CAPACITY]      = "Capacity:",
     [UI_LBL_COUNT]         = "Count:",
+    [UI_LBL_PROFILE]       = "Type:",
     [UI_STR_OPEN]          = "Open",
     [UI_STR_CLOSE]         = "Close",
     [UI_STR_CHARGER_NAME]  = "Charger",
@@ -169,7 +207,8 @@ static const char * const UI_STR_EN[] = {
     [UI_STR_MFG_GAIN]      = "Gain",
     [UI_STR_MFG_OFFSET]    = "Offset",
     [UI_STR_MFG_LIMITS]    = "Max/Min values",
-    [UI_STR_MFG_MODE]      = "Device mode"
+    [UI_STR_MFG_MODE]      = "Device mode",
+    [UI_STR_MFG_TUNE]      = "PID autotune"
 };
 
 static const char * const UI_STR_TR[] = {
@@ -190,6 +229,7 @@ static const char * const UI_STR_TR[] = {
     [UI_LBL_BATV]          = "Aku V:",
     [UI_LBL_CAPACITY]      = "Toplam AH:",
     [UI_LBL_COUNT]         = "Sayi:",
+    [UI_LBL_PROFILE]       = "Tip:",
     [UI_STR_OPEN]          = "Acik",
     [UI_STR_CLOSE]         = "Kapali",
     [UI_STR_CHARGER_NAME]  = "Sarj Cihazi",
@@ -203,7 +243,8 @@ static const char * const UI_STR_TR[] = {
     [UI_STR_MFG_GAIN]      = "Kazanc",
     [UI_STR_MFG_OFFSET]    = "Offset",
     [UI_STR_MFG_LIMITS]    = "Max/Min degerler",
-    [UI_STR_MFG_MODE]      = "Cihaz calisma modu"
+    [UI_STR_MFG_MODE]      = "Cihaz calisma modu",
+    [UI_STR_MFG_TUNE]      = "PID oto ayar"
 };
 
 static const char * const * UI_STR_TABLE[2] = { UI_STR_EN, UI_STR_TR };
@@ -265,6 +306,24 @@ static const char * const OUTCTL_ITEM_EN[2] = { "Battery Current Test", "Short t
 static const char * const OUTCTL_ITEM_TR[2] = { "Aku Akim Testi", "Kisa devre testi" };
 static const char * const * const OUTCTL_ITEM_LANG[2] = { OUTCTL_ITEM_EN, OUTCTL_ITEM_TR };
 
+/* Charger mode second item (Up/Down selects subIndex 0/1) */
+static const char * const OUTCTL_EIS_ITEM[2] = { "Impedance Sweep    ", "Empedans Taramasi  " };
+
+/* Short test state, indexed by ScTestState_t */
+static const char * const SCT_STATE_EN[6] = { "", "Apply short...", "Hiccup try ", "Rec:", "No recovery n:", "No short detected" };
+static const char * const SCT_STATE_TR[6] = { "", "Kisa devre yapin", "Deneme ", "Don:", "Donmedi n:", "Kisa devre yok" };
+static const char * const * const SCT_STATE_LANG[2] = { SCT_STATE_EN, SCT_STATE_TR };
+
+/* Battery current test state, indexed by IrTestState_t */
+static const char * const IRT_STATE_EN[7] = { "", "Settling...", "Settling...", "Measuring...", "Measuring...", "Done", "Failed" };
+static const char * const IRT_STATE_TR[7] = { "", "Oturuyor...", "Oturuyor...", "Olculuyor...", "Olculuyor...", "Tamam", "Basarisiz" };
+static const char * const * const IRT_STATE_LANG[2] = { IRT_STATE_EN, IRT_STATE_TR };
+
+/* Impedance sweep state, indexed by EisState_t */
+static const char * const EIS_STATE_EN[6] = { "", "Sweep ", "Sweep ", "Sweep ", "Done", "Failed" };
+static const char * const EIS_STATE_TR[6] = { "", "Tarama ", "Tarama ", "Tarama ", "Tamam", "Basarisiz" };
+static const char * const * const EIS_STATE_LANG[2] = { EIS_STATE_EN, EIS_STATE_TR };
+
 static inline const char * ui_get(UiStrId id)
 {
     return UI_STR_TABLE[lcdLangId][id];
@@ -346,6 +405,124 @@ void lcd_menu_set_language(uint8_t lang_id) {
     LCD_Clear();
 }
 
+/* PAGE_ENTER_DATA charger items: 0 Bat V, 1 capacity, 2 count, 3 profile */
+static void charger_item_print(uint8_t item, uint8_t editing)
+{
+    if (item == 0) {
+        LCD_Print(STR_BATV);
+        LCD_PrintUInt16((batInfo.batteryVoltage >= 24u) ? 24u : 12u);
+        LCD_WriteChar('V');
+    } else if (item == 1) {
+        LCD_Print(STR_CAPACITY);
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16_1dp(batInfo.batteryCap);
+        if (editing) LCD_WriteChar(']');
+        LCD_Print("Ah");
+    } else if (item == 2) {
+        LCD_Print(STR_COUNT);
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16(batInfo.numberOfBattery);
+        if (editing) LCD_WriteChar(']');
+    } else {
+        LCD_Print(ui_get(UI_LBL_PROFILE));
+        if (editing) LCD_WriteChar('[');
+        LCD_Print(PROFILE_NAMES_LANG[lcdLangId][batInfo.profile]);
+        if (editing) LCD_WriteChar(']');
+    }
+    LCD_WriteChar(' ');
+}
+
+/* PAGE_ENTER_DATA supply items: 0 V set, 1 I max, 2 P max */
+static void supply_item_print(uint8_t item, uint8_t editing)
+{
+    if (item == 0) {
+        LCD_Print("V set:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16_1dp(outputVSet_dV);
+        if (editing) LCD_WriteChar(']');
+        LCD_WriteChar('V');
+    } else if (item == 1) {
+        LCD_Print("I max:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16_1dp(outputIMax_dA);
+        if (editing) LCD_WriteChar(']');
+        LCD_WriteChar(CH_CURR);
+    } else {
+        LCD_Print("P max:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16(outputPMax_W);
+        if (editing) LCD_WriteChar(']');
+        LCD_WriteChar('W');
+    }
+}
+
+/* Soft start switch of the active mode */
+static uint8_t *soft_flag(void)
+{
+    return (operatingMode == MODE_SUPPLY) ? &softChargeOn : &batInfo.softChargeEnabled;
+}
+
+static const char *const REG_MODE_STRINGS[REG_MODE_COUNT] = { "Staged", "MinSel", "Cascade" };
+
+/* PAGE_MFG_LIMITS items: 0 V max, 1 I max, 2 temp max, 3 hiccup off-time, 4 hiccup tries,
+ * 5 soft start, 6 V slope, 7 I slope, 8 regulation mode */
+static void limits_item_print(uint8_t item, uint8_t editing)
+{
+    if (item == 0) {
+        LCD_Print("V Max:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16_1dp(vMax_dV);
+        if (editing) LCD_WriteChar(']');
+        LCD_WriteChar('V');
+    } else if (item == 1) {
+        LCD_Print("I Max:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16_1dp(iMax_dA);
+        if (editing) LCD_WriteChar(']');
+        LCD_WriteChar('A');
+    } else if (item == 2) {
+        LCD_Print("Temp Max:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16(tempMax);
+        if (editing) LCD_WriteChar(']');
+        LCD_WriteChar('C');
+    } else if (item == 3) {
+        LCD_Print("SC off:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16(scOffTime_ms);
+        if (editing) LCD_WriteChar(']');
+        LCD_Print("ms");
+    } else if (item == 4) {
+        LCD_Print("SC tries:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt8(scRetryMax);
+        if (editing) LCD_WriteChar(']');
+    } else if (item == 5) {
+        LCD_Print(ui_get(UI_STR_SOFT_CHARGE));
+        if (editing) LCD_WriteChar('[');
+        LCD_Print(STATUS_STRINGS[*soft_flag() ? 1 : 0]);
+        if (editing) LCD_WriteChar(']');
+    } else if (item == 6) {
+        LCD_Print("Vramp:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16(rampV_mV_ms);
+        if (editing) LCD_WriteChar(']');
+        LCD_Print("mV/ms");
+    } else if (item == 7) {
+        LCD_Print("Iramp:");
+        if (editing) LCD_WriteChar('[');
+        LCD_PrintUInt16(rampI_mA_ms);
+        if (editing) LCD_WriteChar(']');
+        LCD_Print("mA/ms");
+    } else {
+        LCD_Print("Reg:");
+        if (editing) LCD_WriteChar('[');
+        LCD_Print(REG_MODE_STRINGS[regulationMode]);
+        if (editing) LCD_WriteChar(']');
+    }
+    LCD_Print("   ");
+}
+
 /**
  * @brief Handle LCD display rendering
  * @details Renders the current page based on pageID and language
@@ -465,6 +642,40 @@ void lcd_handle(void)
             LCD_SetCursor(14, 2);
             LCD_Print("      "); /* Clear charge state area */
         }
+
+        /* Row 3: latched fault, output was switched off by protect_trip() */
+        LCD_SetCursor(0, 3);
+        if (faultCode == FAULT_NONE && operatingMode == MODE_CHARGER) {
+            /* "SoC:100.0% 12h05m" */
+            char line[21];
+            uint8_t idx = 0;
+            uint16_t pct = socPermille / 10u;
+            const char *a = "SoC:";
+            while (*a) line[idx++] = *a++;
+            if (pct >= 100) line[idx++] = '1';
+            if (pct >= 10) line[idx++] = (char)('0' + (pct / 10u) % 10u);
+            line[idx++] = (char)('0' + pct % 10u);
+            line[idx++] = '.';
+            line[idx++] = (char)('0' + socPermille % 10u);
+            line[idx++] = '%';
+            if (socTimeToFull_min != SOC_TTF_UNKNOWN) {
+                uint16_t h = socTimeToFull_min / 60u;
+                uint8_t m = (uint8_t)(socTimeToFull_min % 60u);
+                if (h > 99) h = 99;
+                line[idx++] = ' ';
+                if (h >= 10) line[idx++] = (char)('0' + h / 10u);
+                line[idx++] = (char)('0' + h % 10u);
+                line[idx++] = 'h';
+                line[idx++] = (char)('0' + m / 10u);
+                line[idx++] = (char)('0' + m % 10u);
+                line[idx++] = 'm';
+            }
+            while (idx < 20) line[idx++] = ' ';
+            line[20] = '\0';
+            LCD_Print(line);
+        } else {
+            LCD_Print(FAULT_NAMES_LANG[lcdLangId][faultCode]);
+        }
     }
         break;
 
@@ -556,80 +767,37 @@ void lcd_handle(void)
         }
         /* Scrolling list with centered '>' at row 2 */
         if (operatingMode == MODE_CHARGER) {
-            uint8_t total = 2u; /* BatV, Toplam AH */
+            uint8_t total = 4u; /* BatV, Toplam AH, Count, Profile */
             uint8_t sel = (uint8_t)(subIndex % total);
-            uint8_t prev = (uint8_t)((sel + total - 1u) % total);
-            uint8_t next = (uint8_t)((sel + 1u) % total);
             /* row1: blank if at top, else previous item */
             LCD_SetCursor(0,1);
             if (sel == 0) {
-            } else {
+                LCD_Print("                    ");
+            }
+            else
+            {
                 LCD_SetCursor(1,1);
-                if (prev == 0)
-                {
-                    LCD_Print(STR_BATV);
-                    {
-                        uint16_t batv;
-                        if (batInfo.batteryVoltage >= 24u) { batv = 24u; } else { batv = 12u; }
-                        LCD_PrintUInt16(batv);
-                        LCD_WriteChar('V');
-                    }
-                }
-                else /* prev == 1 */ 
-                { 
-                    LCD_Print(STR_CAPACITY);
-                    LCD_PrintUInt16_1dp(batInfo.batteryCap);
-                    LCD_Print("Ah"); 
-                }
+                charger_item_print((uint8_t)(sel - 1u), 0u);
             }
-            /* row2 sel */
+            /* row2: selected */
             LCD_SetCursor(0,2);
             LCD_WriteChar('>');
             LCD_SetCursor(1,2);
-            if (sel == 0) {
-                LCD_Print(STR_BATV);
-                {
-                    uint16_t batv;
-                    if (batInfo.batteryVoltage >= 24u) { batv = 24u; } else { batv = 12u; }
-                    LCD_PrintUInt16(batv);
-                    LCD_WriteChar('V');
-                }
-            }
-            else if (sel == 1)
-            {
-                LCD_Print(STR_CAPACITY);
-                if (isEditing) LCD_WriteChar('[');
-                LCD_PrintUInt16_1dp(batInfo.batteryCap);
-                if (isEditing) LCD_WriteChar(']');
-                LCD_Print("Ah");
-            }
+            charger_item_print(sel, isEditing);
             /* row3: blank if at bottom, else next item */
             LCD_SetCursor(0,3);
             if (sel == (uint8_t)(total-1u)) {
                 LCD_Print("                    ");
-            } else {
+            }
+            else
+            {
                 LCD_SetCursor(1,3);
-                if (next == 0)
-                {
-                    LCD_Print(STR_BATV);
-                    { 
-                        uint16_t batv; 
-                        if (batInfo.batteryVoltage >= 24u) { batv = 24u; } else { batv = 12u; }
-                        LCD_PrintUInt16(batv);
-                        LCD_WriteChar('V');
-                    } 
-                }
-                else /* next == 1 */
-                {
-                    LCD_Print(STR_CAPACITY);
-                    LCD_PrintUInt16_1dp(batInfo.batteryCap);
-                    LCD_Print("Ah"); 
-                }
+                charger_item_print((uint8_t)(sel + 1u), 0u);
             }
         }
         else
         {
-            uint8_t total = 2u; /* V set, I max */
+            uint8_t total = 3u; /* V set, I max, P max */
             uint8_t sel = (uint8_t)(subIndex % total);
             /* row1: blank if at top, else previous item */
             LCD_SetCursor(0,1);
@@ -639,30 +807,13 @@ void lcd_handle(void)
             else
             {
                 LCD_SetCursor(1,1);
-                LCD_Print("V set:");
-                LCD_PrintUInt16_1dp(outputVSet_dV);
-                LCD_WriteChar('V');
+                supply_item_print((uint8_t)(sel - 1u), 0u);
             }
             /* row2: selected */
             LCD_SetCursor(0,2);
             LCD_WriteChar('>');
             LCD_SetCursor(1,2);
-            if (sel == 0)
-            {
-                LCD_Print("V set:");
-                if (isEditing) LCD_WriteChar('[');
-                LCD_PrintUInt16_1dp(outputVSet_dV);
-                if (isEditing) LCD_WriteChar(']');
-                LCD_WriteChar('V');
-            }
-            else
-            {
-                LCD_Print("I max:");
-                if (isEditing) LCD_WriteChar('[');
-                LCD_PrintUInt16_1dp(outputIMax_dA);
-                if (isEditing) LCD_WriteChar(']');
-                LCD_WriteChar(CH_CURR);
-            }
+            supply_item_print(sel, isEditing);
             /* row3: blank if at bottom, else next item */
             LCD_SetCursor(0,3);
             if (sel == (uint8_t)(total-1u)) {
@@ -671,9 +822,7 @@ void lcd_handle(void)
             else
             {
                 LCD_SetCursor(1,3);
-                LCD_Print("I max:");
-                LCD_PrintUInt16_1dp(outputIMax_dA);
-                LCD_WriteChar(CH_CURR);
+                supply_item_print((uint8_t)(sel + 1u), 0u);
             }
         }
     }
@@ -691,9 +840,76 @@ void lcd_handle(void)
         LCD_SetCursor(0,2);
         LCD_WriteChar('>');
         LCD_SetCursor(1,2);
-        LCD_Print(OUTCTL_ITEM_LANG[lcdLangId][operatingMode]);
+        if (operatingMode == MODE_CHARGER && subIndex == 1) {
+            LCD_Print(OUTCTL_EIS_ITEM[lcdLangId]);
+        } else {
+            LCD_Print(OUTCTL_ITEM_LANG[lcdLangId][operatingMode]);
+        }
         LCD_SetCursor(0,3);
         LCD_Print("                    ");
+        if (operatingMode == MODE_SUPPLY && scTest.state != SCT_IDLE) {
+            /* row1: peak current and trip time of the last short */
+            if (scTest.state != SCT_WAIT_SHORT && scTest.state != SCT_TIMEOUT) {
+                LCD_SetCursor(1,1);
+                LCD_Print("Ip:");
+                LCD_PrintUInt16_1dp(scTest.peak_dA);
+                LCD_Print("A T:");
+                LCD_PrintUInt16(scTest.tripTime_us);
+                LCD_Print("us");
+            }
+            /* row3: test state */
+            LCD_SetCursor(1,3);
+            LCD_Print(SCT_STATE_LANG[lcdLangId][scTest.state]);
+            if (scTest.state == SCT_HICCUP || scTest.state == SCT_FAILED) {
+                LCD_PrintUInt8(scTest.attempts);
+            } else if (scTest.state == SCT_DONE) {
+                LCD_PrintUInt16(scTest.recovery_ms);
+                LCD_Print("ms n:");
+                LCD_PrintUInt8(scTest.attempts);
+            }
+        }
+        if (operatingMode == MODE_CHARGER && subIndex == 1) {
+            if (eis.state == EIS_DONE) {
+                /* row1: one point of the table every 1.5 s, "200Hz 12.3-j1.4mR" */
+                uint8_t p = (uint8_t)((HAL_GetTick() / 1500u) % EIS_POINTS);
+                int32_t re = eisTable[p].re_uOhm / 100;
+                int32_t im = eisTable[p].im_uOhm / 100;
+                LCD_SetCursor(0,1);
+                if (eisFreq_Hz[p] < 100) LCD_WriteChar(' ');
+                if (eisFreq_Hz[p] < 10) LCD_WriteChar(' ');
+                LCD_PrintUInt16(eisFreq_Hz[p]);
+                LCD_Print("Hz ");
+                if (re < 0) re = 0;
+                LCD_PrintUInt16_1dp((re > 9999) ? 9999u : (uint16_t)re);
+                LCD_Print((im < 0) ? "-j" : "+j");
+                if (im < 0) im = -im;
+                LCD_PrintUInt16_1dp((im > 9999) ? 9999u : (uint16_t)im);
+                LCD_Print("mR");
+            }
+            if (eis.state != EIS_IDLE) {
+                /* row3: sweep state and frequency */
+                LCD_SetCursor(1,3);
+                LCD_Print(EIS_STATE_LANG[lcdLangId][eis.state]);
+                if (eis_active()) {
+                    LCD_PrintUInt16(eisFreq_Hz[eis.point]);
+                    LCD_Print("Hz");
+                }
+            }
+        } else if (operatingMode == MODE_CHARGER && irTest.state != IRT_IDLE) {
+            /* row1: resistance and the current step it was measured with */
+            if (irTest.state == IRT_DONE) {
+                uint32_t r = irTest.r_uOhm / 100u;
+                LCD_SetCursor(1,1);
+                LCD_Print("R:");
+                LCD_PrintUInt16_1dp((r > 9999u) ? 9999u : (uint16_t)r);
+                LCD_Print("mR dI:");
+                LCD_PrintUInt16_1dp(irTest.step_dA);
+                LCD_WriteChar('A');
+            }
+            /* row3: test state */
+            LCD_SetCursor(1,3);
+            LCD_Print(IRT_STATE_LANG[lcdLangId][irTest.state]);
+        }
     }
         break;
 
@@ -890,10 +1106,10 @@ void lcd_handle(void)
                 LCD_WriteChar(c);
             } 
         }
-        /* Items: Company, Gain, Offset, Limits, Mode (circular list) */
+        /* Items: Company, Gain, Offset, Limits, Mode, Tune (circular list) */
         {
-            UiStrId ids[5] = { UI_STR_MFG_COMPANY, UI_STR_MFG_GAIN, UI_STR_MFG_OFFSET, UI_STR_MFG_LIMITS, UI_STR_MFG_MODE };
-            uint8_t total = 5u;
+            UiStrId ids[6] = { UI_STR_MFG_COMPANY, UI_STR_MFG_GAIN, UI_STR_MFG_OFFSET, UI_STR_MFG_LIMITS, UI_STR_MFG_MODE, UI_STR_MFG_TUNE };
+            uint8_t total = 6u;
             uint8_t sel = (uint8_t)(subIndex % total);
             uint8_t prev = (uint8_t)((sel + total - 1u) % total);
             uint8_t next = (uint8_t)((sel + 1u) % total);
@@ -1021,66 +1237,24 @@ void lcd_handle(void)
             while(*t){ char c=*t++; if(c>='a'&&c<='z') c=(char)(c-'a'+'A'); LCD_WriteChar(c);}    
         }
         {
-            uint8_t total = 3u; /* V Max, I Max, Temp Max */
+            uint8_t total = 9u; /* V Max, I Max, Temp Max, SC off, SC tries, Soft, V ramp, I ramp, Reg */
             uint8_t sel = (uint8_t)(subIndex % total);
             uint8_t prev = (uint8_t)((sel + total - 1u) % total);
             uint8_t next = (uint8_t)((sel + 1u) % total);
-            
+
             /* row1 prev */
             LCD_SetCursor(1,1);
-            if (prev == 0) {
-                LCD_Print("V Max:");
-                LCD_PrintUInt16_1dp(vMax_dV);
-                LCD_WriteChar('V');
-            } else if (prev == 1) {
-                LCD_Print("I Max:");
-                LCD_PrintUInt16_1dp(iMax_dA);
-                LCD_WriteChar('A');
-        } else {
-                LCD_Print("Temp Max:");
-                LCD_PrintUInt16(tempMax);
-                LCD_WriteChar('C');
-            }
-            
+            limits_item_print(prev, 0u);
+
             /* row2 current with > */
             LCD_SetCursor(0,2);
             LCD_WriteChar('>');
             LCD_SetCursor(1,2);
-            if (sel == 0) {
-                LCD_Print("V Max:");
-                if (isEditing) LCD_WriteChar('[');
-                LCD_PrintUInt16_1dp(vMax_dV);
-                if (isEditing) LCD_WriteChar(']');
-                LCD_WriteChar('V');
-            } else if (sel == 1) {
-                LCD_Print("I Max:");
-                if (isEditing) LCD_WriteChar('[');
-                LCD_PrintUInt16_1dp(iMax_dA);
-                if (isEditing) LCD_WriteChar(']');
-                LCD_WriteChar('A');
-            } else {
-                LCD_Print("Temp Max:");
-                if (isEditing) LCD_WriteChar('[');
-                LCD_PrintUInt16(tempMax);
-                if (isEditing) LCD_WriteChar(']');
-                LCD_WriteChar('C');
-            }
-            
+            limits_item_print(sel, isEditing);
+
             /* row3 next */
             LCD_SetCursor(1,3);
-            if (next == 0) {
-                LCD_Print("V Max:");
-                LCD_PrintUInt16_1dp(vMax_dV);
-                LCD_WriteChar('V');
-            } else if (next == 1) {
-                LCD_Print("I Max:");
-                LCD_PrintUInt16_1dp(iMax_dA);
-                LCD_WriteChar('A');
-        } else {
-                LCD_Print("Temp Max:");
-                LCD_PrintUInt16(tempMax);
-                LCD_WriteChar('C');
-            }
+            limits_item_print(next, 0u);
         }
     }
         break;
@@ -1118,6 +1292,50 @@ void lcd_handle(void)
     }
         break;
 
+    case PAGE_MFG_TUNE: {
+        LCD_SetCursor(1,0);
+        {
+            const char *t = ui_get(UI_STR_MFG_TUNE);
+            while(*t){ char c=*t++; if(c>='a'&&c<='z') c=(char)(c-'a'+'A'); LCD_WriteChar(c);}
+        }
+        /* row1: loop to tune (Up/Down while idle) */
+        LCD_SetCursor(0,1);
+        LCD_Print(((subIndex % 2u) == AT_LOOP_V) ? ">Loop: V (VBAT)" : ">Loop: I (IDC2)");
+        /* row2: relay state / Ku and Tu */
+        LCD_SetCursor(0,2);
+        switch (autotune.state) {
+        case AT_RUNNING:
+        case AT_MEASURED:
+            LCD_Print("Running, cycle ");
+            LCD_PrintUInt8(autotune.cycles);
+            LCD_Print("   ");
+            break;
+        case AT_DONE:
+            LCD_Print("Ku:");
+            LCD_PrintUInt16((uint16_t)(autotune.ku_q4 >> 4));
+            LCD_Print(" Tu:");
+            LCD_PrintUInt16(autotune.tu_ms);
+            LCD_Print("ms   ");
+            break;
+        case AT_ABORTED:
+            LCD_Print("Aborted, Right:retry");
+            break;
+        default:
+            LCD_Print(deviceOn ? "Right: start        " : "Output off          ");
+            break;
+        }
+        /* row3: tuned gains at this point (Q12), stored as schedule base */
+        LCD_SetCursor(0,3);
+        if (autotune.state == AT_DONE) {
+            LCD_Print("Kp:");
+            LCD_PrintUInt16((uint16_t)((autotune.kp > 65535) ? 65535 : autotune.kp));
+            LCD_Print(" Ki:");
+            LCD_PrintUInt16((uint16_t)((autotune.ki > 65535) ? 65535 : autotune.ki));
+            LCD_Print("   ");
+        }
+    }
+        break;
+
     /* duplicate blocks removed */
 
     default:
@@ -1153,9 +1371,13 @@ void button_handle(void) {
             if (pageID == PAGE_ENTER_DATA) {
                 if (operatingMode == MODE_CHARGER) {
                     if (subIndex==1) batInfo.batteryCap = (uint16_t)editBackupValue;
+                    else if (subIndex==2) batInfo.numberOfBattery = editBackupValue;
+                    else if (subIndex==3) batInfo.profile = (uint8_t)editBackupValue;
+                    profile_apply();
                 } else {
                     if (subIndex==0) outputVSet_dV = editBackupValue;
                     else if (subIndex==1) outputIMax_dA = editBackupValue;
+                    else if (subIndex==2) outputPMax_W = editBackupValue;
                 }
             } else if (pageID == PAGE_OUTPUT_CONTROL) {
                 if (operatingMode == MODE_CHARGER) {
@@ -1168,6 +1390,7 @@ void button_handle(void) {
                 /* restore selected channel gain on cancel */
                 uint8_t sel = (uint8_t)(subIndex % 9u);
                 adcGain[sel] = (int16_t)editBackupValue;
+                adc_idc2_curve_update();
             } else if (pageID == PAGE_MFG_COMPANY) {
                 /* restore company name on cancel */
                 for (int i=0;i<21;i++){ companyName[i] = companyBackup[i]; }
@@ -1190,9 +1413,12 @@ void button_handle(void) {
             lcd_menu_set_page(PAGE_SETTINGS);
             uiNeedsClear = 1u; buttonState = 0; return;
         }
-        else if (pageID == PAGE_MFG_COMPANY || pageID == PAGE_MFG_GAIN || pageID == PAGE_MFG_OFFSET || pageID == PAGE_MFG_LIMITS || pageID == PAGE_MFG_MODE)
+        else if (pageID == PAGE_MFG_COMPANY || pageID == PAGE_MFG_GAIN || pageID == PAGE_MFG_OFFSET || pageID == PAGE_MFG_LIMITS || pageID == PAGE_MFG_MODE || pageID == PAGE_MFG_TUNE)
         {
             /* exit any manufacturer subpage back to manufacturer menu */
+            if (pageID == PAGE_MFG_TUNE) {
+                autotune_abort(); /* relay must not outlive its page */
+            }
             lcd_menu_set_page(PAGE_MFG_MENU);
             uiNeedsClear = 1u; buttonState = 0; return;
         }
@@ -1216,13 +1442,15 @@ void button_handle(void) {
     }
     /* On: set SHUTDOWN2 = 1 (same on all pages) */
     if (buttonState & BUT_ON_M) {
+        protect_clear();
+        charge_start();
         HAL_GPIO_WritePin(SHUTDOWN2_GPIO_Port, SHUTDOWN2_Pin, GPIO_PIN_SET);
         deviceOn = 1;
-        batInfo.chargeState = STATE_BULK;
     }
     /* Off: set SHUTDOWN2 = 0 (same on all pages) 
 	*/
     if (buttonState & BUT_OFF_M) {
+        protect_sc_cancel();
         HAL_GPIO_WritePin(SHUTDOWN2_GPIO_Port, SHUTDOWN2_Pin, GPIO_PIN_RESET);
         deviceOn = 0;
         dacValueI = 0;
@@ -1254,25 +1482,33 @@ void button_handle(void) {
                 if (buttonState & BUT_UP_M) {
                     if (subIndex == 0) { batInfo.batteryVoltage = (batInfo.batteryVoltage >= 24u) ? 12u : 24u; }
                     else if (subIndex == 1 && batInfo.batteryCap < 990) { batInfo.batteryCap += 10; }
+                    else if (subIndex == 2 && batInfo.numberOfBattery < 24) { batInfo.numberOfBattery++; }
+                    else if (subIndex == 3) { batInfo.profile = (uint8_t)((batInfo.profile + 1u) % PROF_COUNT); }
                 }
                 if (buttonState & BUT_DOWN_M) {
                     if (subIndex == 0) { batInfo.batteryVoltage = (batInfo.batteryVoltage >= 24u) ? 12u : 24u; }
                     else if (subIndex == 1 && batInfo.batteryCap > 9) { batInfo.batteryCap -= 10; }
+                    else if (subIndex == 2 && batInfo.numberOfBattery > 1) { batInfo.numberOfBattery--; }
+                    else if (subIndex == 3) { batInfo.profile = (uint8_t)((batInfo.profile + PROF_COUNT - 1u) % PROF_COUNT); }
                 }
+                /* Setpoints follow the selection, charge.c picks them up */
+                profile_apply();
             } else { /* MODE_SUPPLY */
                 if (buttonState & BUT_UP_M) {
                     if (subIndex == 0 && outputVSet_dV < 240) { outputVSet_dV++; }
                     else if (subIndex == 1 && outputIMax_dA < 400) { outputIMax_dA++; }
+                    else if (subIndex == 2 && outputPMax_W < OUT_PMAX_W_MAX) { outputPMax_W += 10; }
                 }
                 if (buttonState & BUT_DOWN_M) {
                     if (subIndex == 0 && outputVSet_dV > 0) { outputVSet_dV--; }
                     else if (subIndex == 1 && outputIMax_dA > 0) { outputIMax_dA--; }
+                    else if (subIndex == 2 && outputPMax_W > 10) { outputPMax_W -= 10; }
                 }
             }
         } else {
             /* Navigate fields with Up/Down */
             uint8_t total;
-            if (operatingMode == MODE_CHARGER) { total = 2u; } else { total = 2u; }
+            if (operatingMode == MODE_CHARGER) { total = 4u; } else { total = 3u; }
             if (buttonState & BUT_UP_M) 
             { 
                 subIndex = (uint8_t)((subIndex + total - 1u) % total); 
@@ -1366,6 +1602,7 @@ void button_handle(void) {
             {
                 uint8_t sel = (uint8_t)(subIndex % 9u);
                 adcGain[sel] = (int16_t)editBackupValue; /* restore on cancel */
+                adc_idc2_curve_update();
                 isEditing = 0u;
             }
             lcd_menu_set_page(PAGE_MFG_MENU);
@@ -1378,6 +1615,7 @@ void button_handle(void) {
             if (buttonState & BUT_UP_M) { if (val < 32767) { val++; } }
             if (buttonState & BUT_DOWN_M) { if (val > 0) { val--; } }
             adcGain[sel] = val;
+            adc_idc2_curve_update(); /* IDC2 segment gains feed the curve */
         }
         else
         {
@@ -1464,17 +1702,17 @@ void button_handle(void) {
         }
         if (buttonState & BUT_UP_M) 
         {
-            subIndex = (uint8_t)((subIndex + 5u - 1u) % 5u);
+            subIndex = (uint8_t)((subIndex + 6u - 1u) % 6u);
         }
         if (buttonState & BUT_DOWN_M) 
         {
-            subIndex = (uint8_t)((subIndex + 1u) % 5u);
+            subIndex = (uint8_t)((subIndex + 1u) % 6u);
         }
         if (buttonState & BUT_RIGHT_M)
         {
             /* Enter selected manufacturer submenu */
-            UiStrId ids[5] = { UI_STR_MFG_COMPANY, UI_STR_MFG_GAIN, UI_STR_MFG_OFFSET, UI_STR_MFG_LIMITS, UI_STR_MFG_MODE };
-            uint8_t sel = (uint8_t)(subIndex % 5u);
+            UiStrId ids[6] = { UI_STR_MFG_COMPANY, UI_STR_MFG_GAIN, UI_STR_MFG_OFFSET, UI_STR_MFG_LIMITS, UI_STR_MFG_MODE, UI_STR_MFG_TUNE };
+            uint8_t sel = (uint8_t)(subIndex % 6u);
             if (ids[sel] == UI_STR_MFG_GAIN) {
                 isEditing = 0u; /* reset edit state when entering gain */
                 subIndex = 0u; /* start from first channel */
@@ -1485,6 +1723,9 @@ void button_handle(void) {
                 lcd_menu_set_page(PAGE_MFG_OFFSET);
             } else if (ids[sel] == UI_STR_MFG_LIMITS) {
                 lcd_menu_set_page(PAGE_MFG_LIMITS);
+            } else if (ids[sel] == UI_STR_MFG_TUNE) {
+                subIndex = 0u; /* V loop first */
+                lcd_menu_set_page(PAGE_MFG_TUNE);
             } else {
                 lcd_menu_set_page(PAGE_MFG_MODE);
             }
@@ -1584,10 +1825,23 @@ void button_handle(void) {
                     editBackupValue = vMax_dV;
                 } else if (subIndex == 1) {
                     editBackupValue = iMax_dA;
-                } else {
+                } else if (subIndex == 2) {
                     editBackupValue = tempMax;
+                } else if (subIndex == 3) {
+                    editBackupValue = scOffTime_ms;
+                } else if (subIndex == 4) {
+                    editBackupValue = scRetryMax;
+                } else if (subIndex == 5) {
+                    editBackupValue = *soft_flag();
+                } else if (subIndex == 6) {
+                    editBackupValue = rampV_mV_ms;
+                } else if (subIndex == 7) {
+                    editBackupValue = rampI_mA_ms;
+                } else {
+                    editBackupValue = regulationMode;
                 }
-                isEditing = 1u;
+                /* The loops are primed for one mode, switch it with the output off */
+                isEditing = (subIndex != 8u || !deviceOn) ? 1u : 0u;
             } else {
                 /* Exit edit mode */
                 isEditing = 0u;
@@ -1599,21 +1853,48 @@ void button_handle(void) {
                 if (subIndex == 0 && vMax_dV < 500) { vMax_dV++; }
                 else if (subIndex == 1 && iMax_dA < 500) { iMax_dA++; }
                 else if (subIndex == 2 && tempMax < 150) { tempMax++; }
+                else if (subIndex == 3 && scOffTime_ms < 10000) { scOffTime_ms += 100; }
+                else if (subIndex == 4 && scRetryMax < 10) { scRetryMax++; }
+                else if (subIndex == 5) { *soft_flag() = 1u; }
+                else if (subIndex == 6 && rampV_mV_ms < OUT_RAMP_MAX) { rampV_mV_ms++; }
+                else if (subIndex == 7 && rampI_mA_ms < OUT_RAMP_MAX) { rampI_mA_ms++; }
+                else if (subIndex == 8 && regulationMode + 1 < REG_MODE_COUNT) { regulationMode++; }
             }
             if (buttonState & BUT_DOWN_M) {
                 if (subIndex == 0 && vMax_dV > 50) { vMax_dV--; }
                 else if (subIndex == 1 && iMax_dA > 10) { iMax_dA--; }
                 else if (subIndex == 2 && tempMax > 50) { tempMax--; }
+                else if (subIndex == 3 && scOffTime_ms > 100) { scOffTime_ms -= 100; }
+                else if (subIndex == 4 && scRetryMax > 0) { scRetryMax--; }
+                else if (subIndex == 5) { *soft_flag() = 0u; }
+                else if (subIndex == 6 && rampV_mV_ms > 1) { rampV_mV_ms--; }
+                else if (subIndex == 7 && rampI_mA_ms > 1) { rampI_mA_ms--; }
+                else if (subIndex == 8 && regulationMode > REG_STAGED) { regulationMode--; }
             }
         } else {
             /* Not editing: Up/Down navigate menu */
             if (buttonState & BUT_UP_M) 
             {
-                subIndex = (uint8_t)((subIndex + 3u - 1u) % 3u);
+                subIndex = (uint8_t)((subIndex + 9u - 1u) % 9u);
             }
             if (buttonState & BUT_DOWN_M) 
             {
-                subIndex = (uint8_t)((subIndex + 1u) % 3u);
+                subIndex = (uint8_t)((subIndex + 1u) % 9u);
+            }
+        }
+        break;
+    case PAGE_MFG_TUNE:
+        /* Loop select and start only while the relay is not running */
+        if (!autotune_active())
+        {
+            if (buttonState & (BUT_UP_M | BUT_DOWN_M))
+            {
+                subIndex = (uint8_t)((subIndex + 1u) % 2u);
+            }
+            if ((buttonState & BUT_RIGHT_M) && deviceOn)
+            {
+                AutotuneLoop_t loop = (AutotuneLoop_t)(subIndex % 2u);
+                autotune_start(loop, (loop == AT_LOOP_V) ? adcBuffer[listVBAT1] : adcIDC2, dacValueV);
             }
         }
         break;
@@ -1698,6 +1979,7 @@ void button_handle(void) {
             if (operatingMode == MODE_CHARGER && subIndex == 0u) {
                 /* Bat V immediate toggle */
                 batInfo.batteryVoltage = (batInfo.batteryVoltage >= 24u) ? 12u : 24u;
+                profile_apply();
             } else {
                 if (!isEditing) {
                     /* enter edit mode and backup current value */
@@ -1706,15 +1988,27 @@ void button_handle(void) {
                         { 
                             editBackupValue = (uint16_t)batInfo.batteryCap; 
                         }
+                        else if (subIndex == 2u)
+                        {
+                            editBackupValue = (uint16_t)batInfo.numberOfBattery;
+                        }
+                        else
+                        {
+                            editBackupValue = batInfo.profile;
+                        }
                     } else {
                         if (subIndex == 0u) 
                         { 
                             editBackupValue = outputVSet_dV; 
                         }
-                        else 
+                        else if (subIndex == 1u) 
                         { 
                             editBackupValue = outputIMax_dA; 
                         }
+                        else 
+                        { 
+                            editBackupValue = outputPMax_W; 
+                        }
                     }
                     isEditing = 1u;
                 } else {
@@ -1723,8 +2017,16 @@ void button_handle(void) {
                 }
             }
         } else if (pageID == PAGE_OUTPUT_CONTROL) {
-            /* Sağ tuş: burada test fonksiyonu çağrılacak */
-            /* TODO: buraya test fonksiyonu gelecek */
+            /* Sağ tuş: kısa devre testi (supply), akü iç direnç testi (charger) */
+            if (operatingMode == MODE_SUPPLY && !shortCircuitTest) {
+                protect_sc_test_start();
+            } else if (operatingMode == MODE_CHARGER) {
+                if (subIndex == 1) {
+                    eis_start();
+                } else {
+                    irtest_start();
+                }
+            }
         } else if (pageID == PAGE_SETTINGS) {
             /* Language: toggle, Brightness: edit, Manufacturer: go to PIN page */
             if (subIndex == 0u) {
@@ -23,8 +23,19 @@
 /* USER CODE BEGIN Includes */
 #include "lcd.h"
 #include "adc.h"
+#include "adc_filter.h"
+#include "mains.h"
 #include "lcdMenu.h"
 #include "out_control.h"
+#include "protect.h"
+#include "feedforward.h"
+#include "autotune.h"
+#include "charge.h"
+#include "profile.h"
+#include "thermal.h"
+#include "soc.h"
+#include "irtest.h"
+#include "eis.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -119,6 +130,8 @@ int main(void)
   MX_TIM2_Init();
   /* USER CODE BEGIN 2 */
   adc_init();
+  protect_init();
+  profile_apply();
   HAL_TIM_Base_Start(&htim3);
 
   LCD_Backlight(1);
@@ -145,73 +158,53 @@ int main(void)
   HAL_GPIO_WritePin(BUZZER_GPIO_Port, BUZZER_Pin, 0);
   HAL_Delay(2500);
   pageID = 1;
+  outControlStart();
   while (1)
   {
 	  switch(mainCounter)
 	  {
 	  case 0:
-		  adcTEMP = adcMeanSum[listTEMP - 1] >> SAMPLE_2N ;
+		  adcTEMP = adc_filter_scaled(listTEMP);
 		  mainCounter++;
 		  break;
 	  case 1:
-		  adcIDC = adcMeanSum[listIDC - 1] >> SAMPLE_2N ;
+		  adcIDC = adc_filter_scaled(listIDC);
 		  mainCounter++;
 		  break;
 	  case 2:
-		  adcVBAT1 = adcMeanSum[listVBAT1 - 1] >> SAMPLE_2N ;
+		  adcVDC1 = adc_filter_scaled(listVDC1);
 		  mainCounter++;
 		  break;
 	  case 3:
-		  adcVDC1 = adcMeanSum[listVDC1 - 1] >> SAMPLE_2N ;
+		  adcVDC2 = adc_filter_scaled(listVDC2);
 		  mainCounter++;
 		  break;
 	  case 4:
-		  adcVDC2 = adcMeanSum[listVDC2 - 1] >> SAMPLE_2N ;
+		  /* adcVBAT1 / adcIDC2 are refreshed by the control tick */
+		  protect_update_limits();
+		  charge_update_limits();
+		  soc_update();
+		  ff_update();
+		  autotune_update();
+		  irtest_update();
+		  eis_update();
 		  mainCounter++;
 		  break;
 	  case 5:
-		  adcIDC2NoGain = adcMeanSum[listIDC2 - 1] >> SAMPLE_2N ;
-		  if(adcIDC2NoGain <= 50)
-		  {
-			  adcIDC2 = (q15_t)(((int32_t)(adcIDC2NoGain) * adcGain[listIDC2]) >> 15);
-		  }
-
-		  else if(adcIDC2NoGain <= 150)
-		  {
-			  adcIDC2 = (q15_t)(((int32_t)(adcIDC2NoGain) * adcGain[listIDC2 + 1]) >> 15);
-		  }
-
-		  else if(adcIDC2NoGain <= 350)
-		  {
-			  adcIDC2 = (q15_t)(((int32_t)(adcIDC2NoGain) * adcGain[listIDC2 + 2]) >> 15);
-		  }
-
-		  else if(adcIDC2NoGain > 350)
-		  {
-			  adcIDC2 = (q15_t)(((int32_t)(adcIDC2NoGain) * adcGain[listIDC2 + 3]) >> 15);
-		  }
-
+		  mains_update();
 		  mainCounter++;
 		  break;
 	  case 6:
-		  adcVAC = sqrt((double) (adcRmsSum / N_VALUE) );
-		  mainCounter++;
-		  break;
-	  case 7:
-		  if(deviceOn == 1)
-		  {
-			  outCalculation();
-		  }
-	  case 8:
 		  lcd_handle();
 		  mainCounter++;
 		  break;
-	  case 9:
+	  case 7:
 		  button_handle();
 		  mainCounter++;
 		  break;
-	  case 10 :
+	  case 8 :
 		  calculationTemp(adcTEMP);
+		  thermal_update();
 		  mainCounter++;
 		  break;
 	  default:
@@ -731,6 +724,13 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+  if (htim->Instance == TIM2)
+  {
+    outControlTick();
+  }
+}
 
 /* USER CODE END 4 */
 
@@ -0,0 +1,100 @@
+/*
+ * mains.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "mains.h"
+#include "fixmath.h"
+
+MAINS_METER mains;
+uint16_t mainsFreq_dHz = 0;
+
+/* Called from the ADC DMA block handler for every VAC sample */
+void mains_sample(int16_t v)
+{
+	MAINS_METER *m = &mains;
+
+	if (v < -MAINS_HYST)
+	{
+		m->armed = 1;
+	}
+
+	if (m->armed && m->prev < 0 && v >= 0)
+	{
+		/* Zero lies (v / (v - prev)) of a sample period before this sample */
+		uint16_t q8 = (uint16_t)(((uint32_t)v << 8) / (uint32_t)(v - m->prev));
+		m->armed = 0;
+
+		if (m->running && ++m->cycles >= MAINS_CYCLES)
+		{
+			m->pubSumSq = m->sumSq;
+			m->pubSamples = m->samples;
+			m->pubPeriodQ8 = (m->samples << 8) + m->startQ8 - q8;
+			m->cycleComplete = 1;
+			m->running = 0;
+		}
+
+		if (!m->running)
+		{
+			m->sumSq = 0;
+			m->samples = 0;
+			m->cycles = 0;
+			m->startQ8 = q8;
+			m->running = 1;
+		}
+	}
+
+	if (m->running)
+	{
+		m->sumSq += (int32_t)v * v;
+		m->samples++;
+		if (m->samples > MAINS_MAX_SAMPLES)
+		{
+			m->running = 0;
+			m->lost = 1;
+		}
+	}
+
+	m->prev = v;
+}
+
+/* Background: publish adcVAC and mainsFreq_dHz after each complete window */
+void mains_update(void)
+{
+	int64_t sumSq;
+	uint32_t samples;
+	uint32_t periodQ8;
+
+	if (mains.lost)
+	{
+		mains.lost = 0;
+		adcVAC = 0;
+		mainsFreq_dHz = 0;
+		return;
+	}
+
+	if (!mains.cycleComplete)
+	{
+		return;
+	}
+
+	__disable_irq();
+	sumSq = mains.pubSumSq;
+	samples = mains.pubSamples;
+	periodQ8 = mains.pubPeriodQ8;
+	mains.cycleComplete = 0;
+	__enable_irq();
+
+	if (samples == 0 || periodQ8 == 0)
+	{
+		return;
+	}
+
+	/* True mean square. The old meter divided 20 samples by 18 and read
+	 * sqrt(20 / 18) high; adcGain[listVAC] carries that factor so the
+	 * calibrated reading is unchanged. */
+	adcVAC = (uint16_t)fx_isqrt64((uint64_t)sumSq / samples);
+	mainsFreq_dHz = (uint16_t)(((uint32_t)ADC_SAMPLE_RATE_HZ * 10u * MAINS_CYCLES * 256u + (periodQ8 >> 1)) / periodQ8);
+}
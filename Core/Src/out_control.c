@@ -8,63 +8,106 @@
 #include "main.h"
 #include "out_control.h"
 #include "adc.h"
+#include "adc_filter.h"
+#include "protect.h"
+#include "feedforward.h"
+#include "autotune.h"
+#include "gainsched.h"
+#include "ramp.h"
+#include "charge.h"
+#include "profile.h"
+#include "thermal.h"
+#include "soc.h"
+#include "irtest.h"
+#include "eis.h"
 
 
 /* Own the control variables here */
 extern DAC_HandleTypeDef hdac;
+extern TIM_HandleTypeDef htim2;
 OperatingMode operatingMode = MODE_CHARGER;
 uint16_t testVoltage_dV = 120;
 uint16_t testCurrent_dA = 50;
 uint16_t outputVSet_dV = 120;
 uint16_t outputIMax_dA = 100;
+uint16_t outputPMax_W = OUT_PMAX_W_MAX;
+uint16_t outputVFold_dV = 0;
 uint8_t  shortCircuitTest = 0;
+uint8_t  softChargeOn = 1;
+uint16_t rampV_mV_ms = OUT_RAMP_V_DEFAULT;
+uint16_t rampI_mA_ms = OUT_RAMP_I_DEFAULT;
 uint8_t  deviceOn = 0;
+RegulationMode_t regulationMode = REG_MIN_SELECT;
+volatile RegulationLoop_t regActiveLoop = REG_LOOP_CC;
 
+volatile uint32_t ctrlTickCount = 0;
+volatile uint32_t ctrlOverrunCount = 0;
+volatile uint32_t ctrlCyclesLast = 0;
+volatile uint32_t ctrlCyclesMax = 0;
+static uint32_t ctrlBudgetCycles = 0;
+static uint8_t  ctrlWasOn = 0;
 
 
-PIDController pidVout =
-{
-  .Kp = PID_VOUT_KP,
-  .Ki = PID_VOUT_KI,
-  .Kd = PID_VOUT_KD,
-
-  .setpoint = 0,
-  .measured = 0,
-
-  .error = 0,
-  .prevError = 0,
-  .integral = 0,
-  .derivative = 0,
-
-  .output = 0,
 
-  .outputMin = PID_VOUT_OUT_MIN,
-  .outputMax = PID_VOUT_OUT_MAX,
+PID_CONTROLLER pidVout =
+{
+  .kp = PID_VOUT_KP,
+  .ki = PID_VOUT_KI,
+  .kd = PID_VOUT_KD,
+  .kb = PID_ONE,
+  .awMode = PID_AW_BACKCALC,
+  .dShift = PID_D_SHIFT,
+
+  .intMin = PID_VOUT_INT_MIN,
+  .intMax = PID_VOUT_INT_MAX,
+  .outMin = PID_DAC_MIN,
+  .outMax = PID_DAC_MAX,
+  .slewMax = PID_VOUT_SLEW,
 };
 
-PIDController pidIout =
+PID_CONTROLLER pidIout =
 {
-  .Kp = PID_IOUT_KP,
-  .Ki = PID_IOUT_KI,
-  .Kd = PID_IOUT_KD,
-
-  .setpoint = 0,
-  .measured = 0,
-
-  .error = 0,
-  .prevError = 0,
-  .integral = 0,
-  .derivative = 0,
-
-  .output = 0,
+  .kp = PID_IOUT_KP,
+  .ki = PID_IOUT_KI,
+  .kd = PID_IOUT_KD,
+  .kb = PID_ONE,
+  .awMode = PID_AW_BACKCALC,
+  .dShift = PID_D_SHIFT,
+
+  .intMin = PID_IOUT_INT_MIN,
+  .intMax = PID_IOUT_INT_MAX,
+  .outMin = PID_DAC_MIN,
+  .outMax = PID_DAC_MAX,
+  .slewMax = PID_IOUT_SLEW,
+};
 
-  .outputMin = PID_IOUT_OUT_MIN,
-  .outputMax = PID_IOUT_OUT_MAX,
+PID_CONTROLLER pidVouter =
+{
+  .kp = PID_VOUTER_KP,
+  .ki = PID_VOUTER_KI,
+  .kd = PID_VOUTER_KD,
+  .kb = PID_ONE,
+  .awMode = PID_AW_BACKCALC,
+  .dShift = PID_D_SHIFT,
+
+  .intMin = 0,
+  .intMax = INT16_MAX << PID_Q,
+  .outMin = 0,
+  .outMax = 0,           /* set every update from the active current limit */
+  .slewMax = 0,
 };
 
+static int32_t pFold_q8 = 0;
+static uint8_t cascadeDiv = 0;
+static uint8_t stagedCvcc = 0;
+static int16_t cascadeIRef = 0;
+static RAMP rampV = { 0, 0 };
+static RAMP rampI = { 0, 0 };
+
 BATTERY_INFO batInfo = {
-    .batteryVoltage             = 120,
+    .batteryVoltage             = 12,
     .batteryCap                 = 90,
+    .profile                    = PROF_AGM,
     .numberOfBattery            = 1,
     .bulkCurrent                = 120,
     .floatVoltage               = 138,
@@ -74,7 +117,7 @@ BATTERY_INFO batInfo = {
     .safeVoltage                = 144,
     .safeStepMV                 = 7,
 
-    .softChargeEnabled          = 0,
+    .softChargeEnabled          = 1,
     .safeChargeEnabled          = 0,
     .equalizationEnabled        = 0,
 
@@ -85,99 +128,324 @@ BATTERY_INFO batInfo = {
     .chargeWeek                 = 0,
 };
 
-int PID_Compute(PIDController *pid, unsigned long setpoint, unsigned long measured)
+/* Voltage target of the active mode/stage */
+static int32_t outVTarget(void)
 {
-    pid->setpoint = setpoint;
-    pid->measured = measured;
+	if (operatingMode == MODE_SUPPLY)
+	{
+		return outputVSet_dV;
+	}
+	return charge_vset();
+}
 
-    pid->error = pid->setpoint - pid->measured ;
+/* Current target of the active mode/stage, derated by the thermal model */
+static int32_t outITarget(void)
+{
+	int32_t i = (operatingMode == MODE_SUPPLY) ? outputIMax_dA : charge_iset();
 
-    pid->integral += pid->error;
-    pid->derivative = pid->error - pid->prevError;
-    pid->prevError = pid->error;
+	return (i * thermalScale_q8) >> TH_Q;
+}
 
+/* Ramped voltage reference of this tick, the constant-power foldback acts
+ * on it directly. The foldback is bounded by outputVSet_dV, not by the ramp,
+ * so the difference is clamped at 0 while the ramp is still low. */
+static int32_t outVSet(void)
+{
+	int32_t v = ramp_value(&rampV);
 
-    if (pid->integral > PID_VOUT_INT_MAX)
-        pid->integral = PID_VOUT_INT_MAX;
-    else if (pid->integral < PID_VOUT_INT_MIN)
-        pid->integral = PID_VOUT_INT_MIN;
+	if (operatingMode == MODE_SUPPLY)
+	{
+		v -= outputVFold_dV;
+	}
+	return (v > 0) ? v : 0;
+}
 
+/* Ramped current reference of this tick */
+static int32_t outISet(void)
+{
+	return ramp_value(&rampI);
+}
 
-    pid->output = pid->Kp * pid->error +
-                  pid->Ki * pid->integral +
-                  pid->Kd * pid->derivative;
+/* Soft start: references start from the measured output when it is switched
+ * on and then follow the targets (enable, stage change, new setpoint) at the
+ * configured slopes. A rising ramp waits while the DAC is at its limit, so
+ * the reference never runs away from an output that cannot follow. */
+static void outRampStep(uint8_t restart)
+{
+	uint8_t soft = (operatingMode == MODE_SUPPLY) ? softChargeOn : batInfo.softChargeEnabled;
+	uint8_t hold = (dacValueV >= PID_DAC_MAX);
 
-    pid->output = pid->output >> 12;
+	rampV.step = soft ? OUT_RAMP_Q16(rampV_mV_ms) : 0;
+	rampI.step = soft ? OUT_RAMP_Q16(rampI_mA_ms) : 0;
+	if (restart)
+	{
+		ramp_reset(&rampV, adcVBAT1);
+		ramp_reset(&rampI, adcIDC2);
+	}
+	ramp_step(&rampV, outVTarget(), hold);
+	ramp_step(&rampI, outITarget(), hold);
+}
 
-    if (pid->output > pid->outputMax)
-        pid->output = pid->outputMax;
-    else if (pid->output < pid->outputMin)
-        pid->output = pid->outputMin;
+/* Constant-power limit: the excess of V*I (dV*dA = 0.01W) over outputPMax_W
+ * is integrated into a foldback of the voltage reference, no division.
+ * The shift rounds to nearest on both signs, so small excesses still count
+ * and the foldback winds up and down at the same rate. */
+static void outPowerFoldback(void)
+{
+	int32_t excess = (int32_t)adcVBAT1 * adcIDC2 - (int32_t)outputPMax_W * 100;
+	int32_t half = 1L << (OUT_PFOLD_SHIFT - 1);
 
-    return pid->output;
+	if (excess >= 0)
+	{
+		pFold_q8 += (excess + half) >> OUT_PFOLD_SHIFT;
+	}
+	else
+	{
+		pFold_q8 -= (half - excess) >> OUT_PFOLD_SHIFT;
+	}
+	if (pFold_q8 < 0)
+	{
+		pFold_q8 = 0;
+	}
+	else if (pFold_q8 > ((int32_t)outputVSet_dV << 8))
+	{
+		pFold_q8 = (int32_t)outputVSet_dV << 8;
+	}
+	outputVFold_dV = (uint16_t)(pFold_q8 >> 8);
+}
+
+/* Feed-forward for this tick: V loop from its setpoint, I loop from the
+ * battery voltage (zero-current point, the PID adds the current). A new
+ * model is installed here and the integrators absorb the model step. */
+static void outFeedForward(void)
+{
+	int32_t vSet = outVSet();
+	int16_t ffV = ff_dac(vSet);
+	int16_t ffI = ff_dac(adcVBAT1);
+
+	if (ff_install())
+	{
+		pidVout.integral -= (int32_t)(ff_dac(vSet) - ffV) << PID_Q;
+		pidIout.integral -= (int32_t)(ff_dac(adcVBAT1) - ffI) << PID_Q;
+		ffV = ff_dac(vSet);
+		ffI = ff_dac(adcVBAT1);
+	}
+	pidVout.feedForward = ffV;
+	pidIout.feedForward = ffI;
+}
+
+/* CC/CV min-select: both loops run every tick and the lower DAC demand wins.
+ * The losing loop tracks the applied output so it cannot wind up. */
+static int16_t outMinSelect(int32_t vSet_dV, int32_t iSet_dA)
+{
+	int16_t dacV = pid_update(&pidVout, vSet_dV, adcBuffer[listVBAT1]);
+	int16_t dacI = pid_update(&pidIout, iSet_dA, adcIDC2);
+
+	if (dacV <= dacI)
+	{
+		pid_track(&pidIout, iSet_dA, adcIDC2, dacV);
+		regActiveLoop = REG_LOOP_CV;
+		return dacV;
+	}
+	pid_track(&pidVout, vSet_dV, adcBuffer[listVBAT1], dacI);
+	regActiveLoop = REG_LOOP_CC;
+	return dacI;
+}
+
+/* Cascade: the outer V loop runs every OUT_CASCADE_DIV ticks and sets the
+ * inner I loop's reference, limited to the active current limit. */
+static int16_t outCascade(int32_t vSet_dV, int32_t iLimit_dA)
+{
+	int16_t dac;
+
+	pidVouter.outMax = (int16_t)iLimit_dA;
+	if (++cascadeDiv >= OUT_CASCADE_DIV)
+	{
+		cascadeDiv = 0;
+		cascadeIRef = pid_update(&pidVouter, vSet_dV, adcVBAT1);
+	}
+	dac = pid_update(&pidIout, cascadeIRef, adcIDC2);
+	if (dac >= PID_DAC_MAX && cascadeIRef > adcIDC2)
+	{
+		/* Inner loop out of headroom: outer follows the current actually delivered */
+		pid_track(&pidVouter, vSet_dV, adcVBAT1, adcIDC2);
+		cascadeIRef = adcIDC2;
+	}
+	regActiveLoop = (cascadeIRef >= iLimit_dA) ? REG_LOOP_CC : REG_LOOP_CV;
+	return dac;
 }
 
 void outCalculation()
 {
+	if (regulationMode != REG_STAGED)
+	{
+		/* Supply: CV at outputVSet_dV, CC at outputIMax_dA; the AWD sits above the CC limit */
+		if (regulationMode == REG_CASCADE)
+		{
+			dacValueV = outCascade(outVSet(), outISet());
+		}
+		else
+		{
+			dacValueV = outMinSelect(outVSet(), outISet());
+		}
+		HAL_DAC_SetValue(&hdac, DAC_CHANNEL_2, DAC_ALIGN_12B_R, dacValueV);
+		return;
+	}
+
 	if(operatingMode == MODE_SUPPLY)
 	{
-		  dacValueV +=PID_Compute(&pidVout, outputVSet_dV, adcBuffer[listVBAT1]);
-		  if(dacValueV > 4095)
-		  {
-			  dacValueV = 4095;
-		  }
-		  else if (dacValueV < 0)
-		  {
-			  dacValueV = 0;
-		  }
+		  dacValueV = pid_update(&pidVout, outVSet(), adcBuffer[listVBAT1]);
 		  if (adcIDC2 > outputIMax_dA)
 		  {
-			  dacValueV = 0;
-			  HAL_GPIO_WritePin(SHUTDOWN2_GPIO_Port, SHUTDOWN2_Pin, 0);
-			  deviceOn = 0;
+			  /* Backup for the AWD trip, on the averaged current */
+			  protect_trip(FAULT_OVERCURRENT);
+			  return;
 		  }
 		  HAL_DAC_SetValue(&hdac, DAC_CHANNEL_2, DAC_ALIGN_12B_R, dacValueV);
 	}
 
 	else
 	{
-		switch(batInfo.chargeState)
+		/* Charger stages (charge.c) pick the loop, the other one is primed on a
+		 * change; SAFE and EQUALIZATION regulate their current limit as well */
+		uint8_t loop = charge_stage_loop();
+
+		if (loop == CHG_LOOP_CVCC)
+		{
+			if (!stagedCvcc)
+			{
+				/* Both loops take over from the DAC value of the last stage */
+				pid_prime(&pidVout, outVSet(), adcBuffer[listVBAT1], dacValueV);
+				pid_prime(&pidIout, outISet(), adcIDC2, dacValueV);
+				stagedCvcc = 1;
+			}
+			dacValueV = outMinSelect(outVSet(), outISet());
+		}
+		else if (loop == CHG_LOOP_CC)
+		{
+			stagedCvcc = 0;
+			if (regActiveLoop != REG_LOOP_CC)
+			{
+				pid_prime(&pidIout, outISet(), adcIDC2, dacValueV);
+				regActiveLoop = REG_LOOP_CC;
+			}
+			dacValueV = pid_update(&pidIout, outISet(), adcIDC2);
+		}
+		else
+		{
+			stagedCvcc = 0;
+			if (regActiveLoop != REG_LOOP_CV)
+			{
+				/* Voltage loop takes over from the current loop's DAC value */
+				pid_prime(&pidVout, outVSet(), adcBuffer[listVBAT1], dacValueV);
+				regActiveLoop = REG_LOOP_CV;
+			}
+			dacValueV = pid_update(&pidVout, outVSet(), adcBuffer[listVBAT1]);
+		}
+		HAL_DAC_SetValue(&hdac, DAC_CHANNEL_2, DAC_ALIGN_12B_R, dacValueV);
+	}
+}
+
+/* Reprogram TIM2 (left at 10 Hz by CubeMX) for the control tick and start it */
+void outControlStart(void)
+{
+	uint32_t period = SystemCoreClock / OUT_CONTROL_RATE_HZ;
+
+	/* DWT cycle counter for the budget check */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	ctrlBudgetCycles = period * OUT_CONTROL_BUDGET_PCT / 100;
+
+	__HAL_TIM_SET_PRESCALER(&htim2, 0);
+	__HAL_TIM_SET_AUTORELOAD(&htim2, period - 1);
+	htim2.Instance->EGR = TIM_EGR_UG;	/* load PSC now, not at the first overflow */
+	__HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_UPDATE);
+
+	HAL_NVIC_SetPriority(TIM2_IRQn, OUT_CONTROL_IRQ_PRIO, 0);
+	HAL_TIM_Base_Start_IT(&htim2);
+}
+
+/* TIM2 update: measurements, PID and DAC at a fixed rate.
+ * The filter outputs change once per DMA half block, the tick only samples them. */
+void outControlTick(void)
+{
+	uint32_t start = DWT->CYCCNT;
+	uint32_t cycles;
+
+	adcVBAT1 = adc_filter_scaled(listVBAT1);
+	adcIDC2NoGain = adc_filter_out(listIDC2);
+	adcIDC2 = pwl_interp(&adcIdc2Curve, adcIDC2NoGain);
+
+	if (deviceOn == 1 && autotune_active())
+	{
+		/* Relay owns the DAC, the loops are primed again when it stops */
+		dacValueV = autotune_step(autotune.loop == AT_LOOP_V ? adcBuffer[listVBAT1] : adcIDC2);
+		HAL_DAC_SetValue(&hdac, DAC_CHANNEL_2, DAC_ALIGN_12B_R, dacValueV);
+		ctrlWasOn = 0;
+	}
+	else if (deviceOn == 1 && irtest_active())
+	{
+		/* Current step test owns the DAC, the loops are primed again when it stops */
+		irtest_tick();
+		ctrlWasOn = 0;
+	}
+	else if (deviceOn == 1 && eis_active())
+	{
+		/* Impedance sweep holds the operating point and adds its sine */
+		eis_tick();
+		ctrlWasOn = 0;
+	}
+	else if (deviceOn == 1)
+	{
+		if (operatingMode == MODE_CHARGER)
+		{
+			charge_tick();
+			soc_tick();
+		}
+		outRampStep(!ctrlWasOn);
+		gs_apply(adcVBAT1, adcIDC2);
+		if (operatingMode == MODE_SUPPLY)
 		{
-		case STATE_BULK:
-			   dacValueV += PID_Compute(&pidIout, batInfo.bulkCurrent / 10, adcIDC2);
-			   if(dacValueV > 4095)
-			   {
-				   dacValueV = 4095;
-			   }
-			   else if (dacValueV < 0)
-			   {
-				   dacValueV = 0;
-			   }
-
-			   HAL_DAC_SetValue(&hdac, DAC_CHANNEL_2, DAC_ALIGN_12B_R, dacValueV);
-			   if(adcVBAT1 >= batInfo.absorptionVoltage)
-			   {
-				   batInfo.chargeState = STATE_ABSORPTION;
-			   }
-			break;
-
-		case STATE_ABSORPTION:
-			  dacValueV +=PID_Compute(&pidVout, batInfo.absorptionVoltage, adcBuffer[listVBAT1]);
-			  if(dacValueV > 4095)
-			  {
-				  dacValueV = 4095;
-			  }
-			  else if (dacValueV < 0)
-			  {
-				  dacValueV = 0;
-			  }
-			  HAL_DAC_SetValue(&hdac, DAC_CHANNEL_2, DAC_ALIGN_12B_R, dacValueV);
-
-			  if(batInfo.absorptionFinishCurrent > adcIDC2)
-			  {
-				//  batInfo.chargeState = STATE_FLOAT;
-			  }
-			  break;
+			outPowerFoldback();
 		}
+		outFeedForward();
+		if (!ctrlWasOn)
+		{
+			/* Output switched on: both loops continue from the present DAC value,
+			 * the references start at the measured output */
+			pid_prime(&pidVout, outVSet(), adcBuffer[listVBAT1], dacValueV);
+			pid_prime(&pidIout, (regulationMode == REG_CASCADE) ? adcIDC2 : outISet(), adcIDC2, dacValueV);
+			pidVouter.outMax = (int16_t)outISet();
+			pid_prime(&pidVouter, outVSet(), adcVBAT1, adcIDC2);
+			cascadeIRef = adcIDC2;
+			ff_restart();
+		}
+		outCalculation();
+		ff_sample(adcVBAT1, dacValueV);
+		ctrlWasOn = 1;
+	}
+	else
+	{
+		autotune_abort();
+		irtest_abort();
+		eis_abort();
+		pFold_q8 = 0;
+		outputVFold_dV = 0;
+		ctrlWasOn = 0;
+	}
+	protect_tick();
+
+	cycles = DWT->CYCCNT - start;
+	ctrlCyclesLast = cycles;
+	if (cycles > ctrlCyclesMax)
+	{
+		ctrlCyclesMax = cycles;
+	}
+	/* Over budget, or the next update is already pending (HAL cleared it before the callback) */
+	if (cycles > ctrlBudgetCycles || __HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE))
+	{
+		ctrlOverrunCount++;
 	}
+	ctrlTickCount++;
 }
@@ -0,0 +1,96 @@
+/*
+ * pid.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "pid.h"
+#include "fixmath.h"
+
+static inline int32_t pid_clamp(int32_t x, int32_t lo, int32_t hi)
+{
+	if (x > hi)
+	{
+		return hi;
+	}
+	if (x < lo)
+	{
+		return lo;
+	}
+	return x;
+}
+
+/* Derivative on the measurement (no kick on setpoint steps), first-order filtered */
+static inline int32_t pid_derivative(PID_CONTROLLER *pid, int32_t measured)
+{
+	int32_t raw = (pid->prevMeasured - measured) << PID_Q;
+
+	pid->prevMeasured = measured;
+	pid->dState += (raw - pid->dState) >> pid->dShift;
+	return fx_mul_shift(pid->dState, pid->kd, PID_Q);
+}
+
+/* kp * error must stay inside int32: |kp| < 2^31 / max error */
+int16_t pid_update(PID_CONTROLLER *pid, int32_t setpoint, int32_t measured)
+{
+	int32_t error = setpoint - measured;
+	int32_t iStep = pid->ki * error;
+	int32_t u, out;
+	int16_t v;
+
+	pid->integral = pid_clamp(pid->integral + iStep, pid->intMin, pid->intMax);
+
+	u = pid->kp * error + pid->integral + pid_derivative(pid, measured)
+	  + ((int32_t)pid->feedForward << PID_Q);
+	v = fx_sat16((u + (PID_ONE >> 1)) >> PID_Q);
+
+	out = pid_clamp(v, pid->outMin, pid->outMax);
+	if (pid->slewMax != 0)
+	{
+		out = pid_clamp(out, pid->output - pid->slewMax, pid->output + pid->slewMax);
+	}
+
+	if (pid->awMode == PID_AW_BACKCALC)
+	{
+		/* Only while limited, the rounding residual must not feed back or a
+		 * ki * error below one output LSB would never accumulate.
+		 * kb = 1.0 makes the integrator follow the applied output exactly. */
+		if (out != v)
+		{
+			pid->integral += fx_mul_shift((out << PID_Q) - u, pid->kb, PID_Q);
+			pid->integral = pid_clamp(pid->integral, pid->intMin, pid->intMax);
+		}
+	}
+	else if ((v > out && iStep > 0) || (v < out && iStep < 0))
+	{
+		/* Limited and still winding in the same direction: drop this step */
+		pid->integral -= iStep;
+	}
+
+	pid->output = (int16_t)out;
+	return pid->output;
+}
+
+/* Bumpless start: next pid_update() continues from 'output' */
+void pid_prime(PID_CONTROLLER *pid, int32_t setpoint, int32_t measured, int16_t output)
+{
+	pid->dState = 0;
+	pid->prevMeasured = measured;
+	pid->integral = pid_clamp(((int32_t)(output - pid->feedForward) << PID_Q)
+							  - pid->kp * (setpoint - measured),
+							  pid->intMin, pid->intMax);
+	pid->output = output;
+}
+
+/* Follow an output driven by someone else. Called after this tick's
+ * pid_update(), so the derivative filter has already seen 'measured'. */
+void pid_track(PID_CONTROLLER *pid, int32_t setpoint, int32_t measured, int16_t output)
+{
+	int32_t d = fx_mul_shift(pid->dState, pid->kd, PID_Q);
+
+	pid->integral = pid_clamp(((int32_t)(output - pid->feedForward) << PID_Q)
+							  - pid->kp * (setpoint - measured) - d,
+							  pid->intMin, pid->intMax);
+	pid->output = output;
+}
@@ -0,0 +1,71 @@
+/*
+ * profile.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "profile.h"
+#include "out_control.h"
+#include "lcdMenu.h"
+
+/* Indexed by BatteryProfile_t */
+const BATTERY_PROFILE batteryProfiles[PROF_COUNT] = {
+	/* PROF_FLOODED: equalization allowed */
+	{ PROF_LEAD(2450), PROF_LEAD(2250), PROF_LEAD(2200), PROF_LEAD(2400), 200, 20, 1, 1, PROF_LEAD_CELLS, -40 },
+	/* PROF_AGM */
+	{ PROF_LEAD(2434), PROF_LEAD(2300), PROF_LEAD(2200), PROF_LEAD(2400), 250, 20, 0, 1, PROF_LEAD_CELLS, -40 },
+	/* PROF_GEL */
+	{ PROF_LEAD(2367), PROF_LEAD(2300), PROF_LEAD(2200), PROF_LEAD(2333), 150, 15, 0, 1, PROF_LEAD_CELLS, -35 },
+	/* PROF_CALCIUM */
+	{ PROF_LEAD(2517), PROF_LEAD(2300), PROF_LEAD(2200), PROF_LEAD(2450), 150, 20, 1, 1, PROF_LEAD_CELLS, -40 },
+	/* PROF_LIFEPO4: BMS handles balancing, no deep-discharge recovery or compensation */
+	{ PROF_LFP(3550),  PROF_LFP(3400),  PROF_LFP(3300),  PROF_LFP(3500),  500, 50, 0, 0, PROF_LFP_CELLS, 0 },
+};
+
+/* 0.1V for 'blocks' 12V blocks, limited to the device maximum */
+static unsigned int profile_v_dV(uint16_t block_mV, uint32_t blocks)
+{
+	uint32_t v = (uint32_t)block_mV * blocks / 100u;
+
+	return (v > vMax_dV) ? vMax_dV : v;
+}
+
+/* Background: batInfo setpoints from the selected profile, the 12/24V
+ * selection, the battery count and the capacity (0.1Ah) */
+void profile_apply(void)
+{
+	const BATTERY_PROFILE *p;
+	uint32_t blocks;
+	uint32_t cap = batInfo.batteryCap;
+	uint32_t bulk;
+	uint32_t finish;
+
+	if (batInfo.profile >= PROF_COUNT)
+	{
+		batInfo.profile = PROF_AGM;
+	}
+	p = &batteryProfiles[batInfo.profile];
+	blocks = batInfo.numberOfBattery * ((batInfo.batteryVoltage >= 24u) ? 2u : 1u);
+
+	batInfo.absorptionVoltage = profile_v_dV(p->absorption_mV, blocks);
+	batInfo.floatVoltage = profile_v_dV(p->float_mV, blocks);
+	batInfo.storageVoltage = profile_v_dV(p->storage_mV, blocks);
+	batInfo.safeVoltage = profile_v_dV(p->safe_mV, blocks);
+
+	/* 0.1Ah * 1/1000 C = 0.1mA: / 100 -> 0.01A bulk, / 1000 -> 0.1A tail */
+	bulk = cap * p->bulk_mC / 100u;
+	if (bulk > (uint32_t)iMax_dA * 10u)
+	{
+		bulk = (uint32_t)iMax_dA * 10u;
+	}
+	finish = cap * p->finish_mC / 1000u;
+	if (finish == 0)
+	{
+		finish = 1;
+	}
+	batInfo.bulkCurrent = bulk;
+	batInfo.absorptionFinishCurrent = finish;
+	batInfo.equalizationEnabled = p->equalization;
+	batInfo.safeChargeEnabled = p->safeCharge;
+}
@@ -0,0 +1,306 @@
+/*
+ * protect.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "protect.h"
+#include "adc.h"
+#include "lcdMenu.h"
+#include "out_control.h"
+#include "adc_filter.h"
+
+volatile FaultCode_t faultCode = FAULT_NONE;
+uint16_t protectOcRaw = 4095;
+
+uint16_t scOffTime_ms = SC_OFF_MS_DEFAULT;
+uint8_t  scRetryMax = SC_RETRY_DEFAULT;
+SC_TEST_RESULT scTest = { .state = SCT_IDLE };
+
+static uint16_t protectLimit_dA = 0xFFFF;
+
+/* Short-circuit detector (DMA ISR) and hiccup engine (control tick) */
+static uint16_t scDiRaw = 0xFFFF;
+static uint16_t scVCollapseRaw = 0;
+static uint16_t scPrevI = 0;
+static uint8_t  scAwdWindow = 0;
+static volatile uint8_t scAwdSeq = 0xFF;   /* first sequence after the AWD event, 0xFF: none */
+static uint32_t scShutdownPins = 0;         /* SHUTDOWN1/2 that were high at the trip */
+static uint16_t scVRecover_dV = 0;
+static uint8_t  scAttempts = 0;
+static uint8_t  scHiccup = 0;
+static uint8_t  scRecovering = 0;
+static uint32_t scTicks = 0;
+
+/* Current limit the power stage must never exceed in the active mode */
+static uint16_t protect_limit_dA(void)
+{
+	uint16_t limit = iMax_dA;
+
+	/* Min-select/cascade regulate at outputIMax_dA, trip only if the CC loop loses it */
+	if (operatingMode == MODE_SUPPLY)
+	{
+		uint16_t supply = outputIMax_dA;
+
+		if (regulationMode != REG_STAGED)
+		{
+			supply += PROTECT_OC_MARGIN_dA;
+		}
+		if (supply < limit)
+		{
+			limit = supply;
+		}
+	}
+	return limit;
+}
+
+void protect_init(void)
+{
+	protect_update_limits();
+	LL_ADC_SetAnalogWDMonitChannels(ADC1, LL_ADC_AWD_CHANNEL_9_REG); /* I_DC2 = PB1 = ADC_IN9 */
+	LL_ADC_SetAnalogWDThresholds(ADC1, LL_ADC_AWD_THRESHOLD_LOW, 0);
+	LL_ADC_ClearFlag_AWD1(ADC1);
+	LL_ADC_EnableIT_AWD1(ADC1);
+}
+
+/* Background: convert the dA limit to a raw AWD threshold when it changes.
+ * The IDC2 curve follows the editable gains, so it is re-evaluated here. */
+void protect_update_limits(void)
+{
+	uint16_t limit = protect_limit_dA();
+	uint16_t raw = (uint16_t)pwl_inverse(&adcIdc2Curve, limit);
+
+	scDiRaw = (uint16_t)pwl_inverse(&adcIdc2Curve, SC_DI_dA);
+	/* Pre-fault reference, frozen while a fault or a hiccup is in progress */
+	if (deviceOn && faultCode == FAULT_NONE && !scHiccup)
+	{
+		scVCollapseRaw = adc_filter_out(listVBAT1) >> SC_VCOLLAPSE_SHIFT;
+		scVRecover_dV = (uint16_t)((uint32_t)adcVBAT1 * SC_RECOVER_PCT / 100u);
+	}
+	scTest.peak_dA = pwl_interp(&adcIdc2Curve, scTest.peakRaw);
+
+	if (limit == protectLimit_dA && raw == protectOcRaw)
+	{
+		return;
+	}
+	protectLimit_dA = limit;
+	protectOcRaw = raw;
+	LL_ADC_SetAnalogWDThresholds(ADC1, LL_ADC_AWD_THRESHOLD_HIGH, raw);
+}
+
+/* Callable from any context: output off first, bookkeeping after */
+void protect_trip(FaultCode_t code)
+{
+	uint32_t pins = SHUTDOWN1_GPIO_Port->ODR & (SHUTDOWN1_Pin | SHUTDOWN2_Pin);
+
+	SHUTDOWN1_GPIO_Port->BRR = SHUTDOWN1_Pin | SHUTDOWN2_Pin; /* same port */
+	DAC->DHR12R2 = 0;
+	dacValueV = 0;
+	deviceOn = 0;
+	outputState = 0;
+
+	if (faultCode == FAULT_NONE)
+	{
+		faultCode = code;
+		scShutdownPins = pins;
+	}
+}
+
+/* Output back on after a trip: SHUTDOWN2 and whatever the trip pulled low with it */
+static void protect_release(void)
+{
+	SHUTDOWN1_GPIO_Port->BSRR = scShutdownPins | SHUTDOWN2_Pin;
+	deviceOn = 1;
+	outputState = 1;
+}
+
+static void protect_rearm(void)
+{
+	faultCode = FAULT_NONE;
+	LL_ADC_ClearFlag_AWD1(ADC1);
+	LL_ADC_EnableIT_AWD1(ADC1);
+}
+
+/* Called before the output is switched on again */
+void protect_clear(void)
+{
+	scAttempts = 0;
+	scHiccup = 0;
+	scRecovering = 0;
+	/* The ON path sets SHUTDOWN2 itself */
+	SHUTDOWN1_GPIO_Port->BSRR = scShutdownPins & SHUTDOWN1_Pin;
+	protect_rearm();
+}
+
+/* Output switched off by the user: no more hiccup restarts, fault stays shown */
+void protect_sc_cancel(void)
+{
+	scHiccup = 0;
+	scRecovering = 0;
+	if (scTest.state == SCT_WAIT_SHORT || scTest.state == SCT_HICCUP)
+	{
+		scTest.state = SCT_IDLE;
+	}
+	shortCircuitTest = 0;
+}
+
+/* Short confirmed (ISR): start the hiccup off-time */
+static void protect_sc_event(uint16_t tripTime_us)
+{
+	faultCode = FAULT_SHORT;
+	scHiccup = 1;
+	scTicks = 0;
+	if (scTest.state == SCT_WAIT_SHORT)
+	{
+		scTest.tripTime_us = tripTime_us;
+		scTest.state = SCT_HICCUP;
+	}
+}
+
+/* ADC1_IRQHandler: AWD fires on the first I_DC2 conversion above the limit.
+ * The DMA position gives the sequence that converted it; the ones before may
+ * still be waiting for their block, so the window starts after it. */
+void protect_adc_irq(void)
+{
+	if (LL_ADC_IsActiveFlag_AWD1(ADC1))
+	{
+		uint32_t done = ADC_DMA_SEQ_COUNT * ADC1_CHANNEL_COUNT
+					  - LL_DMA_GetDataLength(DMA1, LL_DMA_CHANNEL_1);
+
+		protect_trip(FAULT_OVERCURRENT);
+		/* I_DC2 is the last channel: 'done' is past it or one word short */
+		scAwdSeq = (uint8_t)(((done + ADC1_CHANNEL_COUNT - 1u) / ADC1_CHANNEL_COUNT) % ADC_DMA_SEQ_COUNT);
+		scAwdWindow = SC_AWD_WINDOW;
+		/* Stays latched until protect_clear(), avoid an IRQ per conversion */
+		LL_ADC_DisableIT_AWD1(ADC1);
+		LL_ADC_ClearFlag_AWD1(ADC1);
+	}
+}
+
+/* DMA block handler, once per ADC sequence. 'remain' sequences of the block
+ * are newer than this one, they set the sample-to-trip latency. 'seq' is the
+ * sequence's index in adc1Buffer. */
+void protect_sc_sample(uint16_t iRaw, uint16_t vRaw, uint8_t remain, uint8_t seq)
+{
+	int32_t dI = (int32_t)iRaw - scPrevI;
+	uint8_t collapsed = (vRaw < scVCollapseRaw);
+
+	scPrevI = iRaw;
+	if (scTest.state == SCT_WAIT_SHORT || scTest.state == SCT_HICCUP)
+	{
+		if (iRaw > scTest.peakRaw)
+		{
+			scTest.peakRaw = iRaw;
+		}
+	}
+
+	if (scAwdSeq != 0xFF)
+	{
+		/* Sampled before the AWD event (or with it) */
+		if (seq != scAwdSeq)
+		{
+			return;
+		}
+		scAwdSeq = 0xFF;
+	}
+	if (scAwdWindow)
+	{
+		/* AWD was faster: classify its trip from the sequences after it */
+		scAwdWindow--;
+		if (collapsed && faultCode == FAULT_OVERCURRENT)
+		{
+			protect_sc_event(1000000u / ADC_SAMPLE_RATE_HZ);    /* within one sequence */
+		}
+		return;
+	}
+	if (!deviceOn)
+	{
+		return;
+	}
+	if ((dI >= scDiRaw || iRaw >= protectOcRaw) && collapsed)
+	{
+		protect_trip(FAULT_SHORT);
+		protect_sc_event((uint16_t)((remain + 1u) * (1000000u / ADC_SAMPLE_RATE_HZ)));
+	}
+}
+
+/* Control tick: hiccup off-time, restart and recovery bookkeeping */
+void protect_tick(void)
+{
+	uint32_t offTicks = (uint32_t)scOffTime_ms * OUT_CONTROL_RATE_HZ / 1000u;
+	/* Restart deadline: the soft-start ramp up to the recovery voltage + margin */
+	uint32_t recover_ms = SC_RECOVER_MS + (uint32_t)scVRecover_dV * 100u / (rampV_mV_ms ? rampV_mV_ms : 1u);
+
+	if (scTest.state == SCT_WAIT_SHORT && ++scTest.ticks > (uint32_t)SC_TEST_WAIT_MS * OUT_CONTROL_RATE_HZ / 1000u)
+	{
+		scTest.state = SCT_TIMEOUT;
+		shortCircuitTest = 0;
+	}
+
+	if (faultCode == FAULT_SHORT && !deviceOn && scHiccup)
+	{
+		if (scAttempts >= scRetryMax)
+		{
+			/* Latched until ON */
+			if (scTest.state == SCT_HICCUP)
+			{
+				scTest.state = SCT_FAILED;
+				shortCircuitTest = 0;
+			}
+			return;
+		}
+		if (++scTicks >= offTicks)
+		{
+			scTicks = 0;
+			scAttempts++;
+			scRecovering = 1;
+			scTest.attempts = scAttempts;
+			protect_rearm();
+			dacValueV = 0;  /* soft restart, the loops are primed from 0 */
+			protect_release();
+		}
+	}
+	else if (scRecovering && deviceOn)
+	{
+		scTicks++;
+		if (adcVBAT1 >= scVRecover_dV)
+		{
+			if (scTest.state == SCT_HICCUP)
+			{
+				scTest.recovery_ms = (uint16_t)(scTicks * 1000u / OUT_CONTROL_RATE_HZ);
+				scTest.state = SCT_DONE;
+				shortCircuitTest = 0;
+			}
+			scRecovering = 0;
+			scHiccup = 0;
+			scAttempts = 0;
+		}
+		else if (scTicks >= recover_ms * OUT_CONTROL_RATE_HZ / 1000u)
+		{
+			/* Restart did not recover (and no new short was seen): counts as
+			 * a failed attempt, the last one latches SCT_FAILED above */
+			protect_trip(FAULT_SHORT);
+			scRecovering = 0;
+			scTicks = 0;
+		}
+	}
+}
+
+/* Background (menu): switch the output on and wait for the fixture short */
+void protect_sc_test_start(void)
+{
+	scTest.peakRaw = 0;
+	scTest.peak_dA = 0;
+	scTest.tripTime_us = 0;
+	scTest.recovery_ms = 0;
+	scTest.attempts = 0;
+	scTest.ticks = 0;
+	shortCircuitTest = 1;
+	if (!deviceOn)
+	{
+		protect_clear();
+		protect_release();
+	}
+	scTest.state = SCT_WAIT_SHORT;
+}
@@ -0,0 +1,117 @@
+/*
+ * pwl.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "pwl.h"
+
+/* Index of the segment [i, i+1] containing x, binary search */
+static uint8_t pwl_segment(const PWL_TABLE *t, int32_t x)
+{
+	uint8_t lo = 0;
+	uint8_t hi = (uint8_t)(t->count - 1u);
+
+	while ((uint8_t)(hi - lo) > 1u)
+	{
+		uint8_t mid = (uint8_t)((lo + hi) >> 1);
+		if (x < t->pt[mid].x)
+		{
+			hi = mid;
+		}
+		else
+		{
+			lo = mid;
+		}
+	}
+	return lo;
+}
+
+/* Segment slope dy/dx in Q16, rounded */
+static int32_t pwl_slope(const PWL_POINT *p)
+{
+	int64_t dy = (int64_t)(p[1].y - p[0].y) << PWL_SLOPE_Q;
+	int32_t dx = p[1].x - p[0].x;
+
+	return (int32_t)((dy + ((dy < 0) ? -(dx / 2) : dx / 2)) / dx);
+}
+
+/* Background, after the points of a RAM table changed */
+void pwl_update_slopes(const PWL_TABLE *t)
+{
+	for (uint8_t i = 0; i + 1u < t->count; i++)
+	{
+		t->slope[i] = pwl_slope(&t->pt[i]);
+	}
+}
+
+/* y(x) in table units */
+int16_t pwl_interp(const PWL_TABLE *t, int32_t x)
+{
+	return (int16_t)(pwl_interp_q(t, x, 0));
+}
+
+/* y(x) << frac, keeps the fractional part of the interpolation, frac < 16 */
+int32_t pwl_interp_q(const PWL_TABLE *t, int32_t x, uint8_t frac)
+{
+	const PWL_POINT *p;
+	uint8_t i;
+	int32_t slope;
+
+	if (x <= t->pt[0].x)
+	{
+		return (int32_t)t->pt[0].y << frac;
+	}
+	if (x >= t->pt[t->count - 1u].x)
+	{
+		return (int32_t)t->pt[t->count - 1u].y << frac;
+	}
+
+	i = pwl_segment(t, x);
+	p = &t->pt[i];
+	slope = (t->slope != NULL) ? t->slope[i] : pwl_slope(p);
+
+	return ((int32_t)p[0].y << frac) +
+	       (int32_t)(((int64_t)(x - p[0].x) * slope + (1L << (PWL_SLOPE_Q - 1u - frac))) >> (PWL_SLOPE_Q - frac));
+}
+
+/* Smallest x with y(x) >= y, for thresholds on increasing curves.
+ * Returns the last x if y is never reached. Background only. */
+int32_t pwl_inverse(const PWL_TABLE *t, int32_t y)
+{
+	const PWL_POINT *p = t->pt;
+
+	if (y <= p[0].y)
+	{
+		return p[0].x;
+	}
+
+	for (uint8_t i = 0; i + 1u < t->count; i++)
+	{
+		if (p[i + 1u].y >= y && p[i + 1u].y > p[i].y)
+		{
+			int32_t dx = p[i + 1u].x - p[i].x;
+			int32_t dy = p[i + 1u].y - p[i].y;
+			int32_t x;
+
+			if (y <= p[i].y)
+			{
+				return p[i].x;
+			}
+			/* (x - x0) dy / dx >= y - y0 - 1/2 rounded up, then a count either
+			 * way where the Q16 slope rounds across a half step */
+			x = p[i].x + (((2 * (y - p[i].y) - 1) * dx) + 2 * dy - 1) / (2 * dy);
+			while (x > p[i].x && pwl_interp(t, x - 1) >= y)
+			{
+				x--;
+			}
+			while (x < p[i + 1u].x && pwl_interp(t, x) < y)
+			{
+				x++;
+			}
+			return x;
+		}
+	}
+	return p[t->count - 1u].x;
+}
@@ -0,0 +1,51 @@
+/*
+ * ramp.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "ramp.h"
+
+/* Start the ramp from 'value' (target units), e.g. the measured output */
+void ramp_reset(RAMP *r, int32_t value)
+{
+	r->value = value << RAMP_Q;
+}
+
+/* Control tick: one step toward 'target'. 'hold' stops a rising ramp while
+ * the loop that follows it is saturated, falling targets are always taken. */
+int32_t ramp_step(RAMP *r, int32_t target, uint8_t hold)
+{
+	int32_t t = target << RAMP_Q;
+
+	if (r->step == 0)
+	{
+		r->value = t;
+	}
+	else if (r->value < t)
+	{
+		if (!hold)
+		{
+			r->value += r->step;
+			if (r->value > t)
+			{
+				r->value = t;
+			}
+		}
+	}
+	else if (r->value > t)
+	{
+		r->value -= r->step;
+		if (r->value < t)
+		{
+			r->value = t;
+		}
+	}
+	return r->value >> RAMP_Q;
+}
+
+int32_t ramp_value(const RAMP *r)
+{
+	return r->value >> RAMP_Q;
+}
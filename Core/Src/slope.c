@@ -0,0 +1,37 @@
+/*
+ * slope.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "slope.h"
+
+void slope_reset(SLOPE *s)
+{
+	s->n = 0;
+	s->valid = 0;
+	s->sy = 0;
+	s->sty = 0;
+	s->num = 0;
+	s->mean = 0;
+}
+
+/* One sample (12-bit counts keep the sums in 32 bits). Returns 1 when it
+ * closed a window, the next sample starts a new one. */
+uint8_t slope_add(SLOPE *s, int32_t y)
+{
+	s->sy += y;
+	s->sty += (int32_t)s->n * y;
+	if (++s->n < SLOPE_N)
+	{
+		return 0;
+	}
+	s->num = SLOPE_N * s->sty - SLOPE_SUM_T * s->sy;
+	s->mean = s->sy / SLOPE_N;
+	s->valid = 1;
+	s->n = 0;
+	s->sy = 0;
+	s->sty = 0;
+	return 1;
+}
@@ -0,0 +1,164 @@
+/*
+ * soc.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "soc.h"
+#include "adc.h"
+#include "adc_filter.h"
+#include "out_control.h"
+#include "profile.h"
+#include "pwl.h"
+
+/* Resting OCV per 12V block (mV) -> SoC (per mille) */
+static const PWL_POINT socOcvLead[] =
+{
+	{ 11300,    0 }, { 11510,  100 }, { 11660,  200 }, { 11810,  300 },
+	{ 11960,  400 }, { 12100,  500 }, { 12240,  600 }, { 12370,  700 },
+	{ 12500,  800 }, { 12620,  900 }, { 12730, 1000 },
+};
+static const PWL_TABLE socOcvLeadCurve = PWL_TABLE_INIT(socOcvLead);
+
+/* LiFePO4 is flat in the middle, the ends still correct the count */
+static const PWL_POINT socOcvLfp[] =
+{
+	{ 10000,    0 }, { 12000,   90 }, { 12800,  170 }, { 13000,  300 },
+	{ 13100,  400 }, { 13200,  700 }, { 13300,  900 }, { 13400,  990 },
+	{ 13600, 1000 },
+};
+static const PWL_TABLE socOcvLfpCurve = PWL_TABLE_INIT(socOcvLfp);
+
+uint16_t socPermille = 0;
+uint16_t socTimeToFull_min = SOC_TTF_UNKNOWN;
+
+/* Tick side */
+static int64_t socAcc = 0;                  /* Q40 per mille */
+static int64_t socInc = 0;                  /* Q40 per mille per 0.1A tick */
+
+/* Background -> tick handover of an OCV correction */
+static int64_t socSet = 0;
+static volatile uint8_t socSetPending = 0;
+
+/* Background side */
+static uint16_t socCap = 0;
+static uint16_t socRest_s = 0;
+static uint8_t  socValid = 0;
+static uint32_t socLastTick = 0;
+
+/* Control tick, charger mode: one multiply-add, no division */
+void soc_tick(void)
+{
+	if (socSetPending)
+	{
+		socAcc = socSet;
+		socSetPending = 0;
+	}
+	socAcc += socInc * adcIDC2;
+	if (socAcc > ((int64_t)SOC_FULL << SOC_Q))
+	{
+		socAcc = (int64_t)SOC_FULL << SOC_Q;
+	}
+	else if (socAcc < 0)
+	{
+		socAcc = 0;
+	}
+	socPermille = (uint16_t)(socAcc >> SOC_Q);
+}
+
+/* Resting SoC from the filtered V_BAT1; read here, adcVBAT1 is only refreshed
+ * once the control tick runs */
+static uint16_t soc_ocv(void)
+{
+	const BATTERY_PROFILE *p = &batteryProfiles[batInfo.profile];
+	uint32_t blocks = batInfo.numberOfBattery * ((batInfo.batteryVoltage >= 24u) ? 2u : 1u);
+	int32_t block_mV = (int32_t)((uint32_t)adc_filter_scaled(listVBAT1) * 100u / blocks);
+
+	return (uint16_t)pwl_interp((p->cells == PROF_LFP_CELLS) ? &socOcvLfpCurve : &socOcvLeadCurve, block_mV);
+}
+
+/* The tick takes a new count over through the pending flag. While it is not
+ * counting (output off, supply mode) the count is written here. */
+static void soc_set(uint16_t permille)
+{
+	int64_t acc = (int64_t)permille << SOC_Q;
+
+	__disable_irq();
+	if (deviceOn && operatingMode == MODE_CHARGER)
+	{
+		socSet = acc;
+		socSetPending = 1;
+	}
+	else
+	{
+		socAcc = acc;
+		socSetPending = 0;
+		socPermille = permille;
+	}
+	__enable_irq();
+}
+
+/* Background, once per second: tick weight, OCV correction, time to full */
+void soc_update(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint16_t soc = socPermille;
+
+	if (now - socLastTick < 1000u)
+	{
+		return;
+	}
+	socLastTick = now;
+
+	if (batInfo.batteryCap != socCap && batInfo.batteryCap != 0)
+	{
+		/* 0.1Ah = 0.1A for 3600 s */
+		uint64_t full = (uint64_t)batInfo.batteryCap * 3600u * OUT_CONTROL_RATE_HZ;
+
+		socCap = (uint16_t)batInfo.batteryCap;
+		socInc = (int64_t)((((uint64_t)SOC_FULL << SOC_Q) / full) * SOC_CHARGE_EFF_PCT / 100u);
+	}
+
+	if (!socValid)
+	{
+		/* Power-up: the output is off, start from the OCV once the V_BAT1
+		 * filter has settled */
+		if (now < SOC_SEED_MS)
+		{
+			return;
+		}
+		soc_set(soc_ocv());
+		socValid = 1;
+		return;
+	}
+
+	if (adcIDC2 < SOC_REST_dA)
+	{
+		/* After the rest time, one correction step per minute */
+		if (++socRest_s >= SOC_REST_S + 60u)
+		{
+			int32_t err = (int32_t)soc_ocv() - soc;
+
+			socRest_s = SOC_REST_S;
+			soc_set((uint16_t)(soc + (err >> SOC_OCV_SHIFT)));
+		}
+	}
+	else
+	{
+		socRest_s = 0;
+	}
+
+	/* remaining 0.1Ah * 60 / 0.1A = minutes */
+	if (deviceOn && operatingMode == MODE_CHARGER && adcIDC2 >= SOC_REST_dA)
+	{
+		uint32_t rem = (uint32_t)(SOC_FULL - soc) * socCap / SOC_FULL;
+		uint32_t ttf = rem * 60u / adcIDC2;
+
+		socTimeToFull_min = (ttf < SOC_TTF_UNKNOWN) ? (uint16_t)ttf : SOC_TTF_UNKNOWN - 1u;
+	}
+	else
+	{
+		socTimeToFull_min = SOC_TTF_UNKNOWN;
+	}
+}
@@ -24,6 +24,7 @@
 /* USER CODE BEGIN Includes */
 #include "adc.h"
 #include "lcdMenu.h"
+#include "protect.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -251,61 +252,20 @@ void EXTI2_IRQHandler(void)
 void DMA1_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
+	uint32_t isr = DMA1->ISR;
 
-
-	/* VAC */
-	adcBuffer[listVAC] = (q15_t)(((int32_t)(adc1Buffer[listVAC] - dcOffset) * adcGain[listVAC]) >> 15);
-	adcRmsSum = adcRmsSum - adcRmsBuffer[adcRmsBufferPo];
-    adcRmsBuffer[adcRmsBufferPo] = (int32_t)adcBuffer[listVAC] * (int32_t)adcBuffer[listVAC];
-	adcRmsSum = adcRmsSum + adcRmsBuffer[adcRmsBufferPo];
-	adcRmsBufferPo++;
-	if (adcRmsBufferPo >= ADC_RMS_BUFFER_SIZE)
+	/* Half transfer: first ADC_DMA_SEQ_PER_HALF sequences are stable */
+	if (isr & DMA_ISR_HTIF1)
 	{
-		adcRmsBufferPo = 0;
+		DMA1->IFCR = DMA_IFCR_CHTIF1;
+		adc_process_block(&adc1Buffer[0], ADC_DMA_SEQ_PER_HALF);
 	}
 
-	/* TEMP */
-	adcBuffer[listTEMP] = (q15_t)(((int32_t)(adc1Buffer[listTEMP]) * adcGain[listTEMP]) >> 15);
-	adcMeanSum[listTEMP - 1] = adcMeanSum[listTEMP - 1] - adcMeanBuffer[listTEMP - 1][adcMeanBufferPo];
-	adcMeanBuffer[listTEMP - 1][adcMeanBufferPo] = adcBuffer[listTEMP];
-	adcMeanSum[listTEMP - 1] = adcMeanSum[listTEMP - 1] + adcMeanBuffer[listTEMP - 1][adcMeanBufferPo];
-
-	/* IDC */
-	adcBuffer[listIDC] = (q15_t)(((int32_t)(adc1Buffer[listIDC]) * adcGain[listIDC]) >> 15);
-	adcMeanSum[listIDC - 1] = adcMeanSum[listIDC - 1] - adcMeanBuffer[listIDC - 1][adcMeanBufferPo];
-	adcMeanBuffer[listIDC - 1][adcMeanBufferPo] = adcBuffer[listIDC];
-	adcMeanSum[listIDC - 1] = adcMeanSum[listIDC - 1] + adcMeanBuffer[listIDC - 1][adcMeanBufferPo];
-
-	/* VBAT */
-	adcBuffer[listVBAT1] = (q15_t)(((int32_t)(adc1Buffer[listVBAT1]) * adcGain[listVBAT1]) >> 15);
-	adcMeanSum[listVBAT1 - 1] = adcMeanSum[listVBAT1 - 1] - adcMeanBuffer[listVBAT1 - 1][adcMeanBufferPo];
-	adcMeanBuffer[listVBAT1 - 1][adcMeanBufferPo] = adcBuffer[listVBAT1];
-	adcMeanSum[listVBAT1 - 1] = adcMeanSum[listVBAT1 - 1] + adcMeanBuffer[listVBAT1 - 1][adcMeanBufferPo];
-
-	/* VDC1 */
-	adcBuffer[listVDC1] = (q15_t)(((int32_t)(adc1Buffer[listVDC1]) * adcGain[listVDC1]) >> 15);
-	adcMeanSum[listVDC1 - 1] = adcMeanSum[listVDC1 - 1] - adcMeanBuffer[listVDC1 - 1][adcMeanBufferPo];
-	adcMeanBuffer[listVDC1 - 1][adcMeanBufferPo] = adcBuffer[listVDC1];
-	adcMeanSum[listVDC1 - 1] = adcMeanSum[listVDC1 - 1] + adcMeanBuffer[listVDC1 - 1][adcMeanBufferPo];
-
-	/* VDC2 */
-	adcBuffer[listVDC2] = (q15_t)(((int32_t)(adc1Buffer[listVDC2]) * adcGain[listVDC2]) >> 15);
-	adcMeanSum[listVDC2 - 1] = adcMeanSum[listVDC2 - 1] - adcMeanBuffer[listVDC2 - 1][adcMeanBufferPo];
-	adcMeanBuffer[listVDC2 - 1][adcMeanBufferPo] = adcBuffer[listVDC2];
-	adcMeanSum[listVDC2 - 1] = adcMeanSum[listVDC2 - 1] + adcMeanBuffer[listVDC2 - 1][adcMeanBufferPo];
-
-	/* IDC2 */
-	// adcBuffer[listIDC2] = (q15_t)(((int32_t)(adc1Buffer[listIDC2]) * adcGain[listIDC2]) >> 15);
-	adcBuffer[listIDC2] = (q15_t)(int32_t)(adc1Buffer[listIDC2]);
-	adcMeanSum[listIDC2 - 1] = adcMeanSum[listIDC2 - 1] - adcMeanBuffer[listIDC2 - 1][adcMeanBufferPo];
-	adcMeanBuffer[listIDC2 - 1][adcMeanBufferPo] = adcBuffer[listIDC2];
-	adcMeanSum[listIDC2 - 1] = adcMeanSum[listIDC2 - 1] + adcMeanBuffer[listIDC2 - 1][adcMeanBufferPo];
-
-	adcMeanBufferPo++;
-
-	if (adcMeanBufferPo >= ADC_MEAN_BUFFER_SIZE)
+	/* Transfer complete: second half is stable, DMA wraps to the first */
+	if (isr & DMA_ISR_TCIF1)
 	{
-		adcMeanBufferPo = 0;
+		DMA1->IFCR = DMA_IFCR_CTCIF1;
+		adc_process_block(&adc1Buffer[ADC_DMA_SEQ_PER_HALF], ADC_DMA_SEQ_PER_HALF);
 	}
 
   /* USER CODE END DMA1_Channel1_IRQn 0 */
@@ -320,6 +280,7 @@ void DMA1_Channel1_IRQHandler(void)
 void ADC1_IRQHandler(void)
 {
   /* USER CODE BEGIN ADC1_IRQn 0 */
+	protect_adc_irq();
 
   /* USER CODE END ADC1_IRQn 0 */
   /* USER CODE BEGIN ADC1_IRQn 1 */
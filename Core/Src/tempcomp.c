@@ -0,0 +1,60 @@
+/*
+ * tempcomp.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "tempcomp.h"
+#include "profile.h"
+#include "out_control.h"
+#include "adc.h"
+
+int16_t tcLut_dV[TC_POINTS];
+int16_t tcLutRaw[TC_POINTS];
+
+/* Signed division rounded to nearest */
+static int32_t tc_div_round(int32_t num, int32_t den)
+{
+	return (num >= 0) ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+/* Background (charge_update_limits): rebuild both tables */
+void tc_build(void)
+{
+	const BATTERY_PROFILE *p = &batteryProfiles[batInfo.profile];
+	int32_t cells = (int32_t)p->cells * batInfo.numberOfBattery * ((batInfo.batteryVoltage >= 24u) ? 2 : 1);
+	int32_t clamp = (int32_t)TC_CLAMP_mV_CELL * cells;
+	int32_t gain = adcGain[listVBAT1];
+
+	for (uint8_t n = 0; n < TC_POINTS; n++)
+	{
+		int32_t t = TC_T_MIN + ((int32_t)n << TC_T_SHIFT);
+		int32_t mV = tc_div_round((int32_t)p->tcomp_dmV * cells * (t - TC_T_REF), 10);
+
+		if (mV > clamp)
+		{
+			mV = clamp;
+		}
+		else if (mV < -clamp)
+		{
+			mV = -clamp;
+		}
+		tcLut_dV[n] = (int16_t)tc_div_round(mV, 100);
+		tcLutRaw[n] = (gain > 0) ? (int16_t)tc_div_round((int32_t)tcLut_dV[n] << 15, gain) : 0;
+	}
+}
+
+/* Control tick: table entry for a temperature */
+uint8_t tc_index(int16_t t_C)
+{
+	if (t_C <= TC_T_MIN)
+	{
+		return 0;
+	}
+	if (t_C >= TC_T_MAX)
+	{
+		return TC_POINTS - 1;
+	}
+	return (uint8_t)((t_C - TC_T_MIN + (1 << (TC_T_SHIFT - 1))) >> TC_T_SHIFT);
+}
@@ -0,0 +1,91 @@
+/*
+ * thermal.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "thermal.h"
+#include "adc.h"
+#include "lcdMenu.h"
+#include "out_control.h"
+
+uint16_t thermalScale_q8 = 1 << TH_Q;
+int16_t  thermalPredict_C = 0;
+int16_t  thermalAmbient_C = 25;
+
+static int32_t thRise_q8 = 0;       /* model heatsink rise above ambient */
+static int32_t thAmb_q8 = 0;        /* ambient estimate */
+static uint32_t thLastTick = 0;
+static uint8_t thStarted = 0;
+
+/* Background, after calculationTemp(): one model step per second */
+void thermal_update(void)
+{
+	uint32_t now = HAL_GetTick();
+	int32_t loss_cW, riseSs_q8, pred_q8, target, limit;
+
+	if (!thStarted)
+	{
+		thAmb_q8 = (int32_t)temp << TH_Q;
+		thermalAmbient_C = temp;
+		thLastTick = now;
+		thStarted = 1;
+		return;
+	}
+	if (now - thLastTick < 1000u)
+	{
+		return;
+	}
+	thLastTick += 1000u;
+
+	/* Losses: V * I in 0.01W */
+	loss_cW = deviceOn ? (int32_t)adcVBAT1 * adcIDC2 * TH_LOSS_PCT / 100 : 0;
+	loss_cW += TH_LOSS_FIXED_cW;
+	riseSs_q8 = loss_cW * TH_RTH_Q8 / 100;
+
+	thRise_q8 += (riseSs_q8 - thRise_q8) >> TH_TAU_SHIFT;
+	if (thRise_q8 < 0)
+	{
+		thRise_q8 = 0;
+	}
+	/* NTC correction goes to the ambient, the model keeps the dynamics */
+	thAmb_q8 += (((int32_t)temp << TH_Q) - (thAmb_q8 + thRise_q8)) >> TH_OBS_SHIFT;
+	/* The heatsink is never below the air around it */
+	thermalAmbient_C = (int16_t)(thAmb_q8 >> TH_Q);
+	if (thermalAmbient_C > temp)
+	{
+		thermalAmbient_C = temp;
+	}
+
+	pred_q8 = riseSs_q8 + (int32_t)(((int64_t)(thRise_q8 - riseSs_q8) * TH_PREDICT_Q12) >> 12);
+	thermalPredict_C = (int16_t)((thAmb_q8 + pred_q8) >> TH_Q);
+
+	/* Linear from full current at tempMax - margin to TH_SCALE_MIN at tempMax */
+	limit = (int32_t)tempMax;
+	if (thermalPredict_C <= limit - TH_MARGIN_C)
+	{
+		target = 1 << TH_Q;
+	}
+	else if (thermalPredict_C >= limit || temp >= limit)
+	{
+		target = TH_SCALE_MIN;
+	}
+	else
+	{
+		target = TH_SCALE_MIN + (((1 << TH_Q) - TH_SCALE_MIN) * (limit - thermalPredict_C)) / TH_MARGIN_C;
+	}
+
+	if (target < (int32_t)thermalScale_q8 - TH_SCALE_DOWN)
+	{
+		thermalScale_q8 -= TH_SCALE_DOWN;
+	}
+	else if (target > (int32_t)thermalScale_q8 + TH_SCALE_UP)
+	{
+		thermalScale_q8 += TH_SCALE_UP;
+	}
+	else
+	{
+		thermalScale_q8 = (uint16_t)target;
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ * bench.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef TESTS_BENCH_H_
+#define TESTS_BENCH_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Host timing for the bench_* targets (make bench): best of BENCH_RUNS, in
+ * ns and, on x86, TSC cycles per call. Host numbers only rank the variants,
+ * the target cost is read from the DWT counter (ctrlCyclesMax). */
+
+#define BENCH_RUNS  5
+
+static volatile int32_t benchSink;
+
+static inline uint64_t bench_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/* Runs 'stmt' n times per run with the loop index in i */
+#define BENCH(label, n, stmt) \
+	do { \
+		double bestNs = 1e30, bestCyc = 1e30; \
+		for (int run = 0; run < BENCH_RUNS; run++) \
+		{ \
+			uint64_t t0 = bench_ns(), c0 = bench_cycles(); \
+			for (uint32_t i = 0; i < (uint32_t)(n); i++) \
+			{ \
+				stmt; \
+			} \
+			uint64_t c1 = bench_cycles(), t1 = bench_ns(); \
+			if ((double)(t1 - t0) / (n) < bestNs) bestNs = (double)(t1 - t0) / (n); \
+			if ((double)(c1 - c0) / (n) < bestCyc) bestCyc = (double)(c1 - c0) / (n); \
+		} \
+		printf("%-28s %8.2f ns %8.1f cycles\n", (label), bestNs, bestCyc); \
+	} while (0)
+
+#endif /* TESTS_BENCH_H_ */
@@ -0,0 +1,75 @@
+/*
+ * bench_fixmath.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include <math.h>
+#include "bench.h"
+#include "fixmath.h"
+
+/* The host has a hardware sqrt/divider, the M3 runs libm sqrt in soft
+ * float: the libm rows here are a lower bound for the target. */
+
+#define BENCH_N     1000000u
+
+static uint32_t benchIn[1024];
+
+/* Largest |fx - libm| over a pseudo-random sweep, in output LSBs */
+static void accuracy(void)
+{
+	double eSqrt32 = 0, eSqrt64 = 0, eDiv = 0, eQ15 = 0;
+	uint32_t x = 1;
+
+	for (int i = 0; i < 1000000; i++)
+	{
+		uint64_t w;
+		uint32_t d;
+		q15_t a, b;
+
+		x = x * 1664525u + 1013904223u;
+		w = (uint64_t)x << 20;
+		d = (x >> 16) | 2u;
+		a = (q15_t)x;
+		b = (q15_t)(x >> 16);
+
+		eSqrt32 = fmax(eSqrt32, fabs(fx_isqrt32(x) - sqrt((double)x)));
+		eSqrt64 = fmax(eSqrt64, fabs(fx_isqrt64(w) - sqrt((double)w)));
+		eDiv = fmax(eDiv, fabs(fx_div_recip(x >> 16, fx_recip(d)) - (double)(x >> 16) / d));
+		eQ15 = fmax(eQ15, fabs(fx_mul_q15(a, b) - (double)a * b / 32768.0));
+	}
+	printf("max error against libm/double (LSB)\n");
+	printf("%-28s %8.3f\n", "fx_isqrt32 vs sqrt", eSqrt32);
+	printf("%-28s %8.3f\n", "fx_isqrt64 vs sqrt", eSqrt64);
+	printf("%-28s %8.3f\n", "fx_div_recip vs n / d", eDiv);
+	printf("%-28s %8.3f\n", "fx_mul_q15 vs a * b", eQ15);
+}
+
+int main(void)
+{
+	uint32_t x = 7;
+
+	for (uint32_t n = 0; n < 1024u; n++)
+	{
+		x = x * 1664525u + 1013904223u;
+		benchIn[n] = x;
+	}
+	accuracy();
+
+	printf("per call (host)\n");
+	BENCH("fx_isqrt32", BENCH_N, benchSink = (int32_t)fx_isqrt32(benchIn[i & 1023u]));
+	BENCH("sqrt (libm, double)", BENCH_N, benchSink = (int32_t)sqrt((double)benchIn[i & 1023u]));
+	BENCH("fx_isqrt64", BENCH_N, benchSink = (int32_t)fx_isqrt64((uint64_t)benchIn[i & 1023u] << 20));
+	BENCH("sqrt (libm, double) 64-bit", BENCH_N,
+	      benchSink = (int32_t)sqrt((double)((uint64_t)benchIn[i & 1023u] << 20)));
+	BENCH("fx_div_recip", BENCH_N,
+	      benchSink = (int32_t)fx_div_recip(benchIn[i & 1023u] >> 16, benchIn[(i + 1u) & 1023u] | 0x10000u));
+	BENCH("n / d (udiv)", BENCH_N,
+	      benchSink = (int32_t)((benchIn[i & 1023u] >> 16) / ((benchIn[(i + 1u) & 1023u] >> 16) | 2u)));
+	BENCH("fx_mul_q15", BENCH_N,
+	      benchSink = fx_mul_q15((q15_t)benchIn[i & 1023u], (q15_t)benchIn[(i + 1u) & 1023u]));
+	BENCH("fx_mul_q31", BENCH_N,
+	      benchSink = fx_mul_q31((q31_t)benchIn[i & 1023u], (q31_t)benchIn[(i + 1u) & 1023u]));
+	return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * bench_pid.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "bench.h"
+#include "pid.h"
+#include "out_control.h"
+
+#define BENCH_N     1000000u
+
+/* The velocity-form PID_Compute() it replaced, I loop tuning */
+typedef struct
+{
+	int Kp, Ki, Kd;
+	int outputMax, outputMin;
+	long integral, prevError;
+} OLD_PID;
+
+static int old_pid_compute(OLD_PID *pid, long setpoint, long measured)
+{
+	long error = setpoint - measured;
+	long output;
+
+	pid->integral += error;
+	if (pid->integral > 2000)
+	{
+		pid->integral = 2000;
+	}
+	else if (pid->integral < -2000)
+	{
+		pid->integral = -2000;
+	}
+	output = (pid->Kp * error + pid->Ki * pid->integral + pid->Kd * (error - pid->prevError)) >> 12;
+	pid->prevError = error;
+	if (output > pid->outputMax)
+	{
+		output = pid->outputMax;
+	}
+	else if (output < pid->outputMin)
+	{
+		output = pid->outputMin;
+	}
+	return (int)output;
+}
+
+int main(void)
+{
+	PID_CONTROLLER clamp = {
+		.kp = PID_IOUT_KP, .ki = PID_IOUT_KI, .kd = PID_IOUT_KD, .kb = PID_ONE,
+		.awMode = PID_AW_CLAMP, .dShift = PID_D_SHIFT,
+		.intMin = PID_IOUT_INT_MIN, .intMax = PID_IOUT_INT_MAX,
+		.outMin = PID_DAC_MIN, .outMax = PID_DAC_MAX, .slewMax = PID_IOUT_SLEW,
+	};
+	PID_CONTROLLER backcalc = clamp;
+	PID_CONTROLLER full = clamp;
+	OLD_PID old = { 2000, 100, 0, 200, -200, 0, 0 };
+	int32_t dac = 0;
+
+	backcalc.awMode = PID_AW_BACKCALC;
+	full.kp = PID_ONE;
+	full.kd = PID_ONE / 4;
+	full.awMode = PID_AW_BACKCALC;
+	pid_prime(&clamp, 100, 100, 2000);
+	pid_prime(&backcalc, 100, 100, 2000);
+	pid_prime(&full, 100, 100, 2000);
+
+	/* Measurement wanders around the setpoint, the output stays unsaturated */
+	printf("pid_update, per call (host)\n");
+	BENCH("old velocity PID_Compute", BENCH_N,
+	      dac += old_pid_compute(&old, 100, 100 + (int32_t)(i & 7) - 4); benchSink = dac);
+	BENCH("pid_update clamp, I only", BENCH_N,
+	      benchSink = pid_update(&clamp, 100, 100 + (int32_t)(i & 7) - 4));
+	BENCH("pid_update backcalc, I only", BENCH_N,
+	      benchSink = pid_update(&backcalc, 100, 100 + (int32_t)(i & 7) - 4));
+	BENCH("pid_update backcalc, PID", BENCH_N,
+	      benchSink = pid_update(&full, 100, 100 + (int32_t)(i & 7) - 4));
+	return 0;
+}
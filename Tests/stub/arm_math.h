@@ -0,0 +1,18 @@
+/*
+ * arm_math.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+/* Host build stand-in for the CMSIS-DSP types. */
+
+#ifndef STUB_ARM_MATH_H_
+#define STUB_ARM_MATH_H_
+
+#include <stdint.h>
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+#endif /* STUB_ARM_MATH_H_ */
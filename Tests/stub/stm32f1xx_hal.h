@@ -0,0 +1,59 @@
+/*
+ * stm32f1xx_hal.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+/* Host build stand-in: only what the tested modules pull in through main.h. */
+
+#ifndef STUB_STM32F1XX_HAL_H_
+#define STUB_STM32F1XX_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct { volatile uint32_t CR, SWTRIGR, DHR12R1, DHR12L1, DHR8R1, DHR12R2; } DAC_TypeDef;
+typedef struct { DAC_TypeDef *Instance; } DAC_HandleTypeDef;
+typedef struct { volatile uint32_t CRL, CRH, IDR, ODR, BSRR, BRR; } GPIO_TypeDef;
+
+#define GPIO_PIN_0      0x0001u
+#define GPIO_PIN_1      0x0002u
+#define GPIO_PIN_2      0x0004u
+#define GPIO_PIN_3      0x0008u
+#define GPIO_PIN_4      0x0010u
+#define GPIO_PIN_5      0x0020u
+#define GPIO_PIN_6      0x0040u
+#define GPIO_PIN_7      0x0080u
+#define GPIO_PIN_8      0x0100u
+#define GPIO_PIN_9      0x0200u
+#define GPIO_PIN_10     0x0400u
+#define GPIO_PIN_11     0x0800u
+#define GPIO_PIN_12     0x1000u
+#define GPIO_PIN_13     0x2000u
+#define GPIO_PIN_14     0x4000u
+#define GPIO_PIN_15     0x8000u
+
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+
+extern GPIO_TypeDef *GPIOA, *GPIOB, *GPIOC;
+extern void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+
+static inline uint32_t __CLZ(uint32_t x)
+{
+	return (x != 0) ? (uint32_t)__builtin_clz(x) : 32u;
+}
+
+static inline int32_t __SSAT_host(int32_t x, uint32_t bits)
+{
+	int32_t max = (int32_t)((1UL << (bits - 1u)) - 1u);
+
+	return (x > max) ? max : ((x < -max - 1) ? -max - 1 : x);
+}
+#define __SSAT(x, bits)     __SSAT_host((x), (bits))
+
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline void __DMB(void) {}
+
+#endif /* STUB_STM32F1XX_HAL_H_ */
@@ -0,0 +1,8 @@
+/*
+ * stm32f1xx_ll_exti.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+/* Host build stand-in, nothing used by the tested modules. */
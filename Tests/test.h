@@ -0,0 +1,33 @@
+/*
+ * test.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#ifndef TESTS_TEST_H_
+#define TESTS_TEST_H_
+
+#include <stdio.h>
+
+/* Host checks, one executable per module. A failed CHECK prints its line and
+ * the test keeps going, TEST_END() turns the count into the exit code. */
+
+static int testFailures = 0;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) \
+		{ \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+			testFailures++; \
+		} \
+	} while (0)
+
+#define TEST_END() \
+	do { \
+		printf("%s: %s\n", __FILE__, testFailures ? "FAILED" : "ok"); \
+		return testFailures ? 1 : 0; \
+	} while (0)
+
+#endif /* TESTS_TEST_H_ */
@@ -0,0 +1,152 @@
+/*
+ * test_autotune.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include <math.h>
+#include "test.h"
+#include "autotune.h"
+#include "gainsched.h"
+#include "out_control.h"
+
+PID_CONTROLLER pidVout;
+PID_CONTROLLER pidIout;
+
+/* First-order plant with a dead time, one step per control tick:
+ * y += (y0 + k (u - u0) - y) / tau, seen AT_TEST_L ticks late */
+#define AT_TEST_K       0.25    /* units per DAC code */
+#define AT_TEST_TAU     40.0    /* ticks */
+#define AT_TEST_L       8       /* ticks */
+#define AT_TEST_U0      2000
+#define AT_TEST_Y0      120.0
+
+typedef struct
+{
+	double y;
+	double seen[AT_TEST_L + 1];
+} PLANT;
+
+static void plant_init(PLANT *pl)
+{
+	pl->y = AT_TEST_Y0;
+	for (int n = 0; n <= AT_TEST_L; n++)
+	{
+		pl->seen[n] = AT_TEST_Y0;
+	}
+}
+
+static int32_t plant_step(PLANT *pl, int16_t u)
+{
+	pl->y += (AT_TEST_Y0 + AT_TEST_K * (u - AT_TEST_U0) - pl->y) / AT_TEST_TAU;
+	for (int n = AT_TEST_L; n > 0; n--)
+	{
+		pl->seen[n] = pl->seen[n - 1];
+	}
+	pl->seen[0] = pl->y;
+	return (int32_t)lround(pl->seen[AT_TEST_L]);
+}
+
+/* Ultimate gain and period of the plant: phase -pi at w */
+static void plant_ultimate(double *ku_codes, double *tu_ticks)
+{
+	double lo = 0.0, hi = M_PI / AT_TEST_L, w = 0.0;
+
+	for (int n = 0; n < 100; n++)
+	{
+		w = 0.5 * (lo + hi);
+		if (atan(w * AT_TEST_TAU) + w * AT_TEST_L < M_PI)
+		{
+			lo = w;
+		}
+		else
+		{
+			hi = w;
+		}
+	}
+	*ku_codes = sqrt(1.0 + w * w * AT_TEST_TAU * AT_TEST_TAU) / AT_TEST_K;
+	*tu_ticks = 2.0 * M_PI / w;
+}
+
+static void test_relay(void)
+{
+	PLANT pl;
+	int32_t y;
+	double ku, tu;
+	int n;
+
+	plant_init(&pl);
+	y = plant_step(&pl, AT_TEST_U0);
+	autotune_start(AT_LOOP_V, y, AT_TEST_U0);
+	for (n = 0; n < (int)AT_TIMEOUT_TICKS && autotune.state == AT_RUNNING; n++)
+	{
+		y = plant_step(&pl, autotune_step(y));
+	}
+	CHECK(autotune.state == AT_MEASURED);
+	CHECK(autotune_active());
+
+	autotune_update();
+	CHECK(autotune.state == AT_DONE);
+	CHECK(!autotune_active());
+
+	/* Against the exact values: the describing function reads Ku low and Tu
+	 * long on a first-order plant (square-wave harmonics, hysteresis) */
+	plant_ultimate(&ku, &tu);
+	CHECK(autotune.ku_q4 / 16.0 > 0.6 * ku && autotune.ku_q4 / 16.0 < 1.05 * ku);
+	CHECK(autotune.tu_ms * OUT_CONTROL_RATE_HZ / 1000.0 > 0.95 * tu
+		  && autotune.tu_ms * OUT_CONTROL_RATE_HZ / 1000.0 < 1.35 * tu);
+
+	/* Results are the schedule's base gains (scale 1.0 here) */
+	CHECK(autotune.kp > 0 && autotune.ki > 0);
+	CHECK(pidVoutBase.kp == autotune.kp);
+	CHECK(pidVoutBase.ki == autotune.ki);
+	CHECK(pidVoutBase.kd == 0);
+}
+
+/* The tuned PI closes the loop on the same plant */
+static void test_tuned_loop(void)
+{
+	PLANT pl;
+	PID_CONTROLLER p = {
+		.kp = pidVoutBase.kp, .ki = pidVoutBase.ki, .kd = 0, .kb = PID_ONE,
+		.awMode = PID_AW_BACKCALC, .dShift = 3,
+		.intMin = 0, .intMax = 4095L << PID_Q, .outMin = 0, .outMax = 4095,
+	};
+	int32_t y, peak = 0;
+
+	plant_init(&pl);
+	y = plant_step(&pl, AT_TEST_U0);
+	pid_prime(&p, (int32_t)AT_TEST_Y0, y, AT_TEST_U0);
+	for (int n = 0; n < 3000; n++)
+	{
+		y = plant_step(&pl, pid_update(&p, (int32_t)AT_TEST_Y0 + 20, y));
+		if (y > peak)
+		{
+			peak = y;
+		}
+	}
+	CHECK(y == (int32_t)AT_TEST_Y0 + 20);
+	CHECK(peak <= (int32_t)AT_TEST_Y0 + 20 + 12);  /* ZN overshoot, bounded */
+}
+
+static void test_abort(void)
+{
+	autotune_start(AT_LOOP_I, 100, AT_TEST_U0);
+	CHECK(autotune_step(100 + AT_MAX_DEV + 1) == AT_TEST_U0);
+	CHECK(autotune.state == AT_ABORTED);
+
+	/* The relay stays inside the DAC range */
+	autotune_start(AT_LOOP_I, 100, 10);
+	CHECK(autotune.center == PID_DAC_MIN + AT_RELAY_D);
+	autotune_abort();
+	CHECK(autotune.state == AT_ABORTED);
+}
+
+int main(void)
+{
+	test_relay();
+	test_tuned_loop();
+	test_abort();
+	TEST_END();
+}
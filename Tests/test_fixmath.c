@@ -0,0 +1,157 @@
+/*
+ * test_fixmath.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include <math.h>
+#include "test.h"
+#include "fixmath.h"
+
+/* floor(sqrt(x)) by definition: r^2 <= x < (r + 1)^2 */
+static int isqrt_ok(uint64_t x, uint64_t r)
+{
+	return (r * r <= x) && ((r + 1u) * (r + 1u) > x);
+}
+
+static void test_isqrt32(void)
+{
+	uint32_t x;
+
+	for (x = 0; x < 70000u; x++)
+	{
+		CHECK(isqrt_ok(x, fx_isqrt32(x)));
+	}
+	/* Squares and their neighbours over the full range */
+	for (x = 1; x < 65536u; x += 97u)
+	{
+		uint32_t sq = x * x;
+
+		CHECK(fx_isqrt32(sq) == x);
+		CHECK(fx_isqrt32(sq - 1u) == x - 1u);
+	}
+	CHECK(fx_isqrt32(UINT32_MAX) == 65535u);
+}
+
+static void test_isqrt64(void)
+{
+	uint64_t x = 1;
+
+	/* Above 2^32 the 64-bit path is taken */
+	for (int i = 0; i < 200000; i++)
+	{
+		x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+		CHECK(isqrt_ok(x >> 2, fx_isqrt64(x >> 2)));
+	}
+	CHECK(fx_isqrt64(0x100000000ULL) == 65536u);
+	CHECK(fx_isqrt64(0x3FFFFFFFFFFFFFFFULL) == 2147483647u);
+	CHECK(fx_isqrt64(123456u) == fx_isqrt32(123456u));
+}
+
+static void test_recip(void)
+{
+	CHECK(fx_recip(0) == UINT32_MAX);
+	CHECK(fx_recip(1) == UINT32_MAX);
+
+	/* Exact for n, d below 2^16 (fixmath.h) */
+	for (uint32_t d = 2; d < 65536u; d += 13u)
+	{
+		uint32_t r = fx_recip(d);
+
+		for (uint32_t n = 0; n < 65536u; n += 251u)
+		{
+			CHECK(fx_div_recip(n, r) == n / d);
+		}
+		CHECK(fx_div_recip(65535u, r) == 65535u / d);
+	}
+	/* Larger n: at most one high */
+	for (uint32_t d = 3; d < 100000u; d += 997u)
+	{
+		uint32_t r = fx_recip(d);
+		uint32_t n = 0xF0000000u / d * 7u + 5u;
+		uint32_t q = fx_div_recip(n, r);
+
+		CHECK(q == n / d || q == n / d + 1u);
+	}
+}
+
+/* libm reference: exact in double below 2^52 */
+static void test_isqrt_libm(void)
+{
+	uint32_t x = 1;
+
+	for (int i = 0; i < 200000; i++)
+	{
+		x = x * 1664525u + 1013904223u;
+		CHECK(fx_isqrt32(x) == (uint32_t)floor(sqrt((double)x)));
+		CHECK(fx_isqrt64((uint64_t)x << 18) == (uint32_t)floor(sqrt((double)((uint64_t)x << 18))));
+	}
+}
+
+static void test_sat16(void)
+{
+	CHECK(fx_sat16(0) == 0);
+	CHECK(fx_sat16(32767) == 32767);
+	CHECK(fx_sat16(32768) == 32767);
+	CHECK(fx_sat16(-32768) == -32768);
+	CHECK(fx_sat16(-32769) == -32768);
+	CHECK(fx_sat16(INT32_MAX) == 32767);
+	CHECK(fx_sat16(INT32_MIN) == -32768);
+	CHECK(fx_sat16(-1234) == -1234);
+}
+
+/* Rounded to nearest (halves up) against the exact product, saturated */
+static void test_mul_q15(void)
+{
+	for (int32_t a = -32768; a <= 32767; a += 7)
+	{
+		for (int32_t b = -32768; b <= 32767; b += 509)
+		{
+			double exact = floor((double)a * b / 32768.0 + 0.5);
+			int32_t want = (exact > 32767.0) ? 32767 : (int32_t)exact;
+
+			CHECK(fx_mul_q15((q15_t)a, (q15_t)b) == want);
+		}
+	}
+	CHECK(fx_mul_q15(-32768, -32768) == 32767);
+	CHECK(fx_mul_q15(-32768, 32767) == -32767);
+	CHECK(fx_mul_q15(16384, 16384) == 8192);    /* 0.5 * 0.5 */
+	CHECK(fx_mul_q15(1, 16384) == 1);           /* 0.5 LSB rounds up */
+	CHECK(fx_mul_q15(-1, 16384) == 0);
+}
+
+/* Truncated toward minus infinity against the exact product, saturated */
+static void test_mul_q31(void)
+{
+	uint32_t r = 12345;
+
+	for (int i = 0; i < 200000; i++)
+	{
+		q31_t a, b;
+		long double exact;
+
+		r = r * 1664525u + 1013904223u;
+		a = (q31_t)r;
+		r = r * 1664525u + 1013904223u;
+		b = (q31_t)r;
+		exact = floorl((long double)a * b / 2147483648.0L);
+		CHECK(fx_mul_q31(a, b) == (q31_t)exact);
+	}
+	CHECK(fx_mul_q31(INT32_MIN, INT32_MIN) == INT32_MAX);
+	CHECK(fx_mul_q31(INT32_MIN, INT32_MAX) == -INT32_MAX);
+	CHECK(fx_mul_q31(1 << 30, 1 << 30) == 1 << 29);
+	CHECK(fx_mul_q31(-1, 1) == -1);
+}
+
+int main(void)
+{
+	test_isqrt32();
+	test_isqrt64();
+	test_isqrt_libm();
+	test_recip();
+	test_sat16();
+	test_mul_q15();
+	test_mul_q31();
+	TEST_END();
+}
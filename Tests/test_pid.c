@@ -0,0 +1,131 @@
+/*
+ * test_pid.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "test.h"
+#include "pid.h"
+
+static PID_CONTROLLER pid_make(PID_AW_MODE aw, int32_t kp, int32_t ki)
+{
+	PID_CONTROLLER p = {
+		.kp = kp, .ki = ki, .kd = 0, .kb = PID_ONE, .awMode = aw, .dShift = 3,
+		.intMin = 0, .intMax = 4095L << PID_Q, .outMin = 0, .outMax = 4095,
+	};
+	return p;
+}
+
+static void test_proportional(void)
+{
+	PID_CONTROLLER p = pid_make(PID_AW_CLAMP, 3 * PID_ONE / 2, 0);
+
+	p.feedForward = 100;
+	CHECK(pid_update(&p, 50, 40) == 115);      /* 1.5 * 10 + 100 */
+	CHECK(pid_update(&p, 50, 50) == 100);
+	CHECK(pid_update(&p, 5000, 0) == 4095);     /* clamped */
+	CHECK(pid_update(&p, 0, 5000) == 0);
+}
+
+/* ki * error below one output LSB must still integrate */
+static void test_small_integral(void)
+{
+	for (int aw = PID_AW_CLAMP; aw <= PID_AW_BACKCALC; aw++)
+	{
+		PID_CONTROLLER p = pid_make((PID_AW_MODE)aw, 0, 2000);
+		int16_t out = 0;
+
+		pid_prime(&p, 0, 0, 1000);
+		for (int n = 0; n < 100; n++)
+		{
+			out = pid_update(&p, 1, 0);
+		}
+		/* 100 * 2000 / 4096 = 48.8 */
+		CHECK(out >= 1048 && out <= 1049);
+	}
+}
+
+/* Long saturation, then the error reverses: no windup to unwind */
+static void test_windup(void)
+{
+	for (int aw = PID_AW_CLAMP; aw <= PID_AW_BACKCALC; aw++)
+	{
+		PID_CONTROLLER p = pid_make((PID_AW_MODE)aw, PID_ONE, PID_ONE / 4);
+		int16_t out;
+
+		p.outMax = 2000;
+		for (int n = 0; n < 5000; n++)
+		{
+			out = pid_update(&p, 1000, 0);
+		}
+		CHECK(out == 2000);
+		out = pid_update(&p, 1000, 1100);
+		out = pid_update(&p, 1000, 1100);
+		CHECK(out < 2000);
+	}
+}
+
+static void test_slew(void)
+{
+	PID_CONTROLLER p = pid_make(PID_AW_BACKCALC, PID_ONE, PID_ONE / 8);
+	int16_t prev = 0, out;
+
+	p.slewMax = 50;
+	for (int n = 0; n < 200; n++)
+	{
+		out = pid_update(&p, 3000, 0);
+		CHECK(out - prev <= 50);
+		prev = out;
+	}
+	CHECK(out == 4095);
+	out = pid_update(&p, 0, 3000);
+	CHECK(prev - out <= 50);
+}
+
+static void test_prime_track(void)
+{
+	PID_CONTROLLER p = pid_make(PID_AW_CLAMP, 2 * PID_ONE, PID_ONE / 16);
+	int16_t out;
+
+	p.kd = PID_ONE;
+	p.feedForward = 200;
+	pid_prime(&p, 120, 100, 1500);
+	out = pid_update(&p, 120, 100);
+	CHECK(out >= 1500 && out <= 1502);         /* only this update's ki * error */
+
+	/* Someone else drove 800: the next update continues from there */
+	pid_track(&p, 120, 100, 800);
+	out = pid_update(&p, 120, 100);
+	CHECK(out >= 800 && out <= 802);
+}
+
+/* First-order plant y += (g u - y) / tau, the loop must remove the offset */
+static void test_closed_loop(void)
+{
+	for (int aw = PID_AW_CLAMP; aw <= PID_AW_BACKCALC; aw++)
+	{
+		PID_CONTROLLER p = pid_make((PID_AW_MODE)aw, PID_ONE / 2, 400);
+		int32_t y = 0;     /* Q8 */
+
+		p.slewMax = 20;
+		for (int n = 0; n < 20000; n++)
+		{
+			int16_t u = pid_update(&p, 150, (y + 128) >> 8);
+
+			y += ((u * 256 / 10) - y) / 20;
+		}
+		CHECK(((y + 128) >> 8) == 150);
+	}
+}
+
+int main(void)
+{
+	test_proportional();
+	test_small_integral();
+	test_windup();
+	test_slew();
+	test_prime_track();
+	test_closed_loop();
+	TEST_END();
+}
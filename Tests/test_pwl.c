@@ -0,0 +1,100 @@
+/*
+ * test_pwl.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include "test.h"
+#include "pwl.h"
+
+/* IDC2 shape from the default segment gains, and a falling NTC-like curve */
+static PWL_POINT idc2Points[] = {
+	{ 0, 0 }, { 25, 11 }, { 100, 12 }, { 250, 25 }, { 2222, 174 }, { 4095, 321 },
+};
+static int32_t idc2Slope[5];
+static const PWL_TABLE idc2Curve = PWL_TABLE_INIT_SLOPE(idc2Points, idc2Slope);
+static const PWL_TABLE idc2CurveDiv = PWL_TABLE_INIT(idc2Points);
+
+static const PWL_POINT ntcPoints[] = {
+	{ 300, 1250 }, { 900, 800 }, { 2000, 250 }, { 3700, -200 },
+};
+static const PWL_TABLE ntcCurve = PWL_TABLE_INIT(ntcPoints);
+
+/* Exact line through the segment of x, x inside the table */
+static double pwl_exact(const PWL_TABLE *t, int32_t x)
+{
+	uint8_t i = 0;
+
+	while (i + 2u < t->count && x >= t->pt[i + 1u].x)
+	{
+		i++;
+	}
+	return t->pt[i].y + (double)(x - t->pt[i].x) * (t->pt[i + 1u].y - t->pt[i].y)
+	       / (t->pt[i + 1u].x - t->pt[i].x);
+}
+
+/* Within half a step of the exact line, plus the Q16 slope error:
+ * half a Q16 unit per count, 0.015 over the longest IDC2 segment */
+static void test_interp(const PWL_TABLE *t, uint8_t frac)
+{
+	int32_t x0 = t->pt[0].x;
+	int32_t x1 = t->pt[t->count - 1u].x;
+
+	for (int32_t x = x0; x <= x1; x++)
+	{
+		double e = (double)pwl_interp_q(t, x, frac) / (1 << frac) - pwl_exact(t, x);
+		double tol = 0.5 / (1 << frac) + 0.015;
+
+		CHECK(e <= tol && e >= -tol);
+	}
+	for (uint8_t i = 0; i < t->count; i++)
+	{
+		CHECK(pwl_interp(t, t->pt[i].x) == t->pt[i].y);
+	}
+	CHECK(pwl_interp(t, x0 - 100) == t->pt[0].y);
+	CHECK(pwl_interp(t, x1 + 100) == t->pt[t->count - 1u].y);
+}
+
+static void test_slopes(void)
+{
+	pwl_update_slopes(&idc2Curve);
+	test_interp(&idc2Curve, 0);
+	test_interp(&idc2Curve, 8);
+	test_interp(&ntcCurve, 0);
+	test_interp(&ntcCurve, 4);
+
+	/* Cached and per-lookup slopes give the same curve */
+	for (int32_t x = 0; x <= 4095; x++)
+	{
+		CHECK(pwl_interp(&idc2Curve, x) == pwl_interp(&idc2CurveDiv, x));
+	}
+
+	/* Rebuilt after the points change */
+	idc2Points[5].y = 400;
+	pwl_update_slopes(&idc2Curve);
+	CHECK(pwl_interp(&idc2Curve, 4095) == 400);
+	test_interp(&idc2Curve, 0);
+	idc2Points[5].y = 321;
+	pwl_update_slopes(&idc2Curve);
+}
+
+/* Smallest x with y(x) >= y */
+static void test_inverse(void)
+{
+	for (int32_t y = 0; y <= 321; y++)
+	{
+		int32_t x = pwl_inverse(&idc2Curve, y);
+
+		CHECK(pwl_interp(&idc2Curve, x) >= y);
+		CHECK(x == 0 || pwl_interp(&idc2Curve, x - 1) < y);
+	}
+	CHECK(pwl_inverse(&idc2Curve, 1000) == 4095);
+}
+
+int main(void)
+{
+	test_slopes();
+	test_inverse();
+	TEST_END();
+}
@@ -0,0 +1,174 @@
+/*
+ * test_slope.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: Ziya
+ */
+
+#include <math.h>
+#include "test.h"
+#include "slope.h"
+#include "charge.h"
+#include "adc.h"
+#include "adc_filter.h"
+#include "pwl.h"
+#include "profile.h"
+#include "protect.h"
+
+/* charge.c environment: V_BAT1 gain 4800 (12.0V = 819 counts), I_DC2 4 counts per 0.1A */
+static const PWL_POINT testIdc2Points[] = { { 0, 0 }, { 4092, 1023 } };
+const PWL_TABLE adcIdc2Curve = PWL_TABLE_INIT(testIdc2Points);
+
+int16_t adcGain[ADC1_CHANNEL_COUNT + 3] = { [listVBAT1] = 4800 };
+uint16_t adcIDC2NoGain;
+uint16_t adcVBAT1;
+int16_t temp = 25;
+int16_t thermalAmbient_C = 25;
+uint16_t vMax_dV = 300;
+uint16_t iMax_dA = 150;
+uint8_t deviceOn = 1;
+GPIO_TypeDef *GPIOC;
+BATTERY_INFO batInfo = {
+	.batteryVoltage = 12, .batteryCap = 90, .profile = PROF_AGM, .numberOfBattery = 1,
+	.bulkCurrent = 200, .floatVoltage = 138, .absorptionVoltage = 146,
+	.absorptionFinishCurrent = 5, .storageVoltage = 132, .safeVoltage = 144, .safeStepMV = 7,
+};
+
+static uint16_t testVRaw;
+
+uint16_t adc_filter_out(uint8_t ch)
+{
+	return (ch == listVBAT1) ? testVRaw : adcIDC2NoGain;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {}
+void protect_trip(FaultCode_t code) {}
+
+static uint16_t v_raw(double v_dV)
+{
+	return (uint16_t)lround(v_dV * 32768.0 / 4800.0);
+}
+
+static void test_window(void)
+{
+	SLOPE s;
+	int n;
+
+	/* y = 100 + 3t: num is exactly 3 * SLOPE_DEN */
+	slope_reset(&s);
+	for (n = 0; n < SLOPE_N - 1; n++)
+	{
+		CHECK(slope_add(&s, 100 + 3 * n) == 0);
+	}
+	CHECK(s.valid == 0);
+	CHECK(slope_add(&s, 100 + 3 * n) == 1);
+	CHECK(s.valid == 1);
+	CHECK(s.num == 3 * SLOPE_DEN);
+	CHECK(s.mean == 100 + 3 * (SLOPE_N - 1) / 2);
+
+	/* Next window starts fresh: flat, falling */
+	for (n = 0; n < SLOPE_N; n++)
+	{
+		slope_add(&s, 4000);
+	}
+	CHECK(s.num == 0 && s.mean == 4000);
+	for (n = 0; n < SLOPE_N; n++)
+	{
+		slope_add(&s, 4095 - 2 * n);
+	}
+	CHECK(s.num == -2 * SLOPE_DEN);
+
+	/* 12-bit extremes stay inside 32 bits: same as 64-bit sums */
+	{
+		int64_t sy = 0, sty = 0;
+
+		for (n = 0; n < SLOPE_N; n++)
+		{
+			int32_t y = (n & 1) ? 4095 : 0;
+
+			sy += y;
+			sty += (int64_t)n * y;
+			slope_add(&s, y);
+		}
+		CHECK(s.mean == 2047);
+		CHECK(s.num == SLOPE_N * sty - SLOPE_SUM_T * sy);
+	}
+}
+
+/* ABSORPTION with i(t) = floor + (i0 - floor) exp(-t / tau) + ripple (amps,
+ * minutes) and a voltage rising dv_min volts per minute. Returns the minute the
+ * taper exit left ABSORPTION, -1 if it did not within 'limit' minutes. */
+static double run_absorption(double floor_A, double tau_min, double dv_min, double limit)
+{
+	double v = 146.0 + 2.0;
+
+	testVRaw = v_raw(v);
+	adcIDC2NoGain = 800;
+	charge_update_limits();
+	charge_start();
+	while (batInfo.chargeState == STATE_BULK)
+	{
+		charge_tick();
+	}
+	CHECK(batInfo.chargeState == STATE_ABSORPTION);
+
+	for (long t = 0; t < (long)(limit * CHG_TICKS_PER_MIN); t++)
+	{
+		double m = (double)t / CHG_TICKS_PER_MIN;
+		double i = floor_A + (5.0 - floor_A) * exp(-m / tau_min) + 0.05 * sin(t * 0.0021);
+
+		adcIDC2NoGain = (uint16_t)lround(i * 40.0);
+		testVRaw = v_raw(v + dv_min * 10.0 * m);
+		charge_tick();
+		if (batInfo.chargeState != STATE_ABSORPTION)
+		{
+			return m;
+		}
+	}
+	return -1.0;
+}
+
+static void test_taper(void)
+{
+	double m;
+
+	/* Settles at 0.2A, below the 0.5A finish current: ends soon after it
+	 * crosses 0.5A (tau ln(4.8 / 0.3) = 27.7 min) and settles */
+	m = run_absorption(0.2, 10.0, 0.0, 120.0);
+	CHECK(m > 27.7);
+	CHECK(m < 40.0);
+
+	/* Aged battery, tail settles at 0.8A: no taper exit */
+	CHECK(run_absorption(0.8, 10.0, 0.0, 120.0) < 0.0);
+
+	/* Low current but the voltage still climbs 20mV/min: not settled */
+	CHECK(run_absorption(0.2, 10.0, 0.02, 120.0) < 0.0);
+}
+
+/* Profile currents feed the taper exit, so the units are checked here */
+static void test_profile(void)
+{
+	BATTERY_INFO saved = batInfo;
+
+	/* 40.0Ah AGM: 0.25C bulk = 10.00A, 0.02C tail = 0.8A */
+	batInfo.batteryCap = 400;
+	profile_apply();
+	CHECK(batInfo.bulkCurrent == 1000);
+	CHECK(batInfo.absorptionFinishCurrent == 8);
+
+	/* 99.0Ah AGM: bulk limited to iMax_dA, tail 1.98A */
+	batInfo.batteryCap = 990;
+	profile_apply();
+	CHECK(batInfo.bulkCurrent == (uint32_t)iMax_dA * 10u);
+	CHECK(batInfo.absorptionFinishCurrent == 19);
+
+	batInfo = saved;
+}
+
+int main(void)
+{
+	test_window();
+	test_taper();
+	test_profile();
+	TEST_END();
+}